@@ -0,0 +1,143 @@
+#
+/*
+ *    Copyright (C) 2025
+ *    Jan van Katwijk (J.vanKatwijk@gmail.com)
+ *    Lazy Chair Computing
+ *
+ *    This file is part of sdrplay_tcp
+ *
+ *    sdrplay_tcp is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    sdrplay_tcp is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with sdrplay_tcp; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+//
+//	Benchmark of the RingBuffer (support/ringbuffer.h) against the
+//	implementation it replaced (ringbuffer-old.h), with the element
+//	type the server uses. It is not part of the server, build it with
+//
+//	g++ -O2 -std=c++17 -I../support ringbuffer-bench.cpp
+//	                  ../support/mirrored-buffer.cpp -lpthread
+//	(in the bench directory)
+//
+//	For block sizes of 16, 256 and 1008 samples and a buffer of 32k
+//	samples it prints, in MS/s, the best of 5 runs of
+//	- put followed by get, in one thread, and
+//	- a producer thread writing through the write regions and a
+//	  consumer thread reading, where every sample is checked.
+#include	"ringbuffer.h"
+#include	"ringbuffer-old.h"
+#include	<stdio.h>
+#include	<stdint.h>
+#include	<complex>
+#include	<vector>
+#include	<thread>
+#include	<chrono>
+#include	<algorithm>
+
+#define	BUFFER_SIZE	32768
+#define	NR_SAMPLES	20000000
+#define	NR_RUNS		5
+
+typedef	std::complex<int16_t>	sample;
+
+static
+double	megaSamples	(std::chrono::steady_clock::time_point start,
+	                                               uint64_t amount) {
+std::chrono::duration<double> elapsed =
+	                 std::chrono::steady_clock::now () - start;
+	return amount / elapsed. count () / 1e6;
+}
+
+template <class buffer>
+double	oneThread	(int block) {
+buffer	rb (BUFFER_SIZE);
+std::vector<sample> src (block);
+std::vector<sample> dst (block);
+auto	start	= std::chrono::steady_clock::now ();
+	for (uint64_t n = 0; n < NR_SAMPLES; n += block) {
+	   rb. putDataIntoBuffer (src. data (), block);
+	   rb. getDataFromBuffer (dst. data (), block);
+	}
+	return megaSamples (start, NR_SAMPLES);
+}
+//
+//	the producer numbers the samples, the consumer checks them
+template <class buffer>
+double	twoThreads	(int block, bool &ok) {
+buffer	rb (BUFFER_SIZE);
+std::vector<sample> dst (block);
+uint64_t n	= 0;
+auto	start	= std::chrono::steady_clock::now ();
+std::thread producer ([&rb, block] () {
+	uint64_t n	= 0;
+	while (n < NR_SAMPLES) {
+	   void	*data1, *data2;
+	   int32_t size1, size2;
+	   int	k	= rb. GetRingBufferWriteRegions (block,
+	                                  &data1, &size1, &data2, &size2);
+	   if (k == 0) {
+	      std::this_thread::yield ();
+	      continue;
+	   }
+	   sample *p1	= (sample *)data1;
+	   sample *p2	= (sample *)data2;
+	   for (int i = 0; i < size1; i ++)
+	      p1 [i]	= sample ((int16_t)(n + i), 0);
+	   for (int i = 0; i < size2; i ++)
+	      p2 [i]	= sample ((int16_t)(n + size1 + i), 0);
+	   rb. AdvanceRingBufferWriteIndex (k);
+	   n	+= k;
+	}
+});
+	ok	= true;
+	while (n < NR_SAMPLES) {
+	   int k	= rb. getDataFromBuffer (dst. data (), block);
+	   if (k == 0) {
+	      std::this_thread::yield ();
+	      continue;
+	   }
+	   for (int i = 0; i < k; i ++)
+	      if (dst [i]. real () != (int16_t)(n + i))
+	         ok	= false;
+	   n	+= k;
+	}
+	producer. join ();
+	return megaSamples (start, NR_SAMPLES);
+}
+
+int	main	() {
+	printf ("block   put+get, one thread   producer/consumer threads\n");
+	printf ("        old       new         old       new\n");
+	for (int block : {16, 256, 1008}) {
+	   double old_1	= 0, new_1	= 0;
+	   double old_2	= 0, new_2	= 0;
+	   bool	oldOk	= true, newOk	= true;
+	   for (int r = 0; r < NR_RUNS; r ++) {
+	      bool ok;
+	      old_1	= std::max (old_1, oneThread<OldRingBuffer<sample>> (block));
+	      new_1	= std::max (new_1, oneThread<RingBuffer<sample>> (block));
+	      old_2	= std::max (old_2,
+	                         twoThreads<OldRingBuffer<sample>> (block, ok));
+	      oldOk	= oldOk && ok;
+	      new_2	= std::max (new_2,
+	                         twoThreads<RingBuffer<sample>> (block, ok));
+	      newOk	= newOk && ok;
+	   }
+	   printf ("%-7d %-9.0f %-11.0f %-9.0f %-9.0f %s\n",
+	           block, old_1, new_1, old_2, new_2,
+	           oldOk && newOk ? "" : "WRONG SAMPLES");
+	}
+	printf ("%u hardware threads\n", std::thread::hardware_concurrency ());
+	return 0;
+}
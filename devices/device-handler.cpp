@@ -23,9 +23,12 @@
 
 #include	"device-handler.h"
 //
-	deviceHandler::deviceHandler	(RingBuffer<std::complex<uint8_t>> *b):
+	deviceHandler::deviceHandler	(broadcastRing<std::complex<int16_t>> *b):
 	                        myFrame (nullptr) {
 	_I_Buffer	= b;
+	dataNotifier	= nullptr;
+	notifyThreshold	= 2048;
+	notified	= 0;
 	lastFrequency	= 100000;
 	theGain		= 50;
 }
@@ -61,8 +64,11 @@ void	deviceHandler::tcp_setFrequency		(int freq) {
 	(void)freq;
 }
 
-void	deviceHandler::tcp_setSampleRate	(int rate) {
+void	deviceHandler::tcp_setSampleRate	(int rate,
+	                                 std::function<void (bool)> done) {
 	(void)rate;
+	if (done)
+	   done (false);
 }
 
 void	deviceHandler::tcp_setGainMode		(bool gainMode) {
@@ -85,3 +91,26 @@ void	deviceHandler::tcp_setBiasT		(bool b) {
 	(void)b;
 }
 
+QString	deviceHandler::commandStatistics	() {
+	return "";
+}
+
+void	deviceHandler::setNotifier	(sampleNotifier *notifier,
+	                                 int threshold) {
+	notifyThreshold	= threshold;
+	dataNotifier	= notifier;
+}
+//
+//	to be called by the device after adding samples to the buffer.
+//	The buffer has several readers, so we count what was written
+void	deviceHandler::dataAvailable	() {
+uint64_t written;
+	if (dataNotifier == nullptr)
+	   return;
+	written	= _I_Buffer -> writePosition ();
+	if (written - notified >= (uint64_t)notifyThreshold) {
+	   notified	= written;
+	   dataNotifier -> notify ();
+	}
+}
+
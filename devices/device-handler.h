@@ -23,9 +23,12 @@
 #pragma once
 
 #include	<cstdint>
+#include	<complex>
+#include	<functional>
 #include	<QFrame>
 #include	<QThread>
-#include	"ringbuffer.h"
+#include	"broadcast-ring.h"
+#include	"sample-notifier.h"
 //	We provide a simple interface to the devices. Note that
 //	it is not just an abstract interface,
 //	it provides a number of shared functions (like hide and show).
@@ -35,7 +38,7 @@
 class	deviceHandler: public QThread {
 Q_OBJECT
 public:
-			deviceHandler	(RingBuffer<std::complex<uint8_t>> *);
+			deviceHandler	(broadcastRing<std::complex<int16_t>> *);
 virtual			~deviceHandler	();
 virtual		bool	restartReader	(int32_t freq);
 virtual		void	stopReader	();
@@ -46,18 +49,32 @@ virtual		int32_t	getVFOFrequency	();
 virtual		int32_t	getRate		();
 //
 //	implementing the "commands" (to start with)
+//	a rate change may be asynchronous, "done" tells whether the
+//	device (possibly from another thread) delivers the new rate
 virtual		void	tcp_setFrequency	(int);
-virtual		void	tcp_setSampleRate	(int);
+virtual		void	tcp_setSampleRate	(int,
+	                                 std::function<void (bool)> done);
 virtual		void	tcp_setGainMode		(bool);
 virtual		void	tcp_setGain		(int);
 virtual		void	tcp_setAgc		(int);
 virtual		void	tcp_setPpm		(int);
 virtual		void	tcp_setBiasT		(bool);
+//
+//	how long the commands take, if the device keeps track
+virtual		QString	commandStatistics	();
+//
+//	the consumer of the samples is woken up each time at least
+//	"threshold" samples were added
+		void	setNotifier		(sampleNotifier *, int threshold);
 
 protected:
 		QFrame	myFrame;
 		int32_t	lastFrequency;
 	        int	theGain;
-	        RingBuffer<std::complex<uint8_t>> *_I_Buffer;
+	        broadcastRing<std::complex<int16_t>> *_I_Buffer;
+		sampleNotifier	*dataNotifier;
+		int	notifyThreshold;
+		uint64_t	notified;
+		void	dataAvailable		();
 };
 
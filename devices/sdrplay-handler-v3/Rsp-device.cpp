@@ -231,11 +231,12 @@ sdrplay_api_ErrT err;
            showState (errorString);
 	   return false;
         }
+	return true;
 }
 
 bool	RspDevice::set_SampleRate	(int samplerate)  {
 sdrplay_api_ErrT err;
-	deviceParams    -> devParams	-> fsFreq. fsHz    = SAMPLERATE;
+	deviceParams    -> devParams	-> fsFreq. fsHz    = samplerate;
 	err =  parent -> sdrplay_api_Update (chosenDevice -> dev,
 	                                    chosenDevice -> tuner,
 	                                    sdrplay_api_Update_Dev_Fs,
@@ -248,6 +249,54 @@ sdrplay_api_ErrT err;
 	return true;
 }
 
+//
+//	The samplerate, the IF, the bandwidth and the decimator are set
+//	in one update, since an IF is only valid with some samplerates
+//	and bandwidths.
+//	The decimator takes a power of two, 2 .. 32, a factor 1 switches
+//	it off. The "narrow band" filters are used, they are slower to
+//	settle but suppress the aliases better. In the low IF modes the
+//	API already shifts the IF to zero and decimates by 4, the
+//	decimator is then kept off.
+//	If the update fails, the previous settings are kept
+bool	RspDevice::set_Mode	(int samplerate, int ifType,
+	                         int bandwidth, int decimation)  {
+sdrplay_api_ErrT err;
+double	oldRate			= deviceParams -> devParams -> fsFreq. fsHz;
+sdrplay_api_If_kHzT oldIf	= chParams -> tunerParams. ifType;
+sdrplay_api_Bw_MHzT oldBw	= chParams -> tunerParams. bwType;
+sdrplay_api_DecimationT old	= chParams -> ctrlParams. decimation;
+	deviceParams    -> devParams	-> fsFreq. fsHz    = samplerate;
+	chParams	-> tunerParams. ifType	=
+	                              sdrplay_api_If_kHzT (ifType);
+	chParams	-> tunerParams. bwType	=
+	                              sdrplay_api_Bw_MHzT (bandwidth);
+	if (sdrplay_api_If_kHzT (ifType) != sdrplay_api_IF_Zero)
+	   decimation	= 1;
+	chParams	-> ctrlParams. decimation. enable	= decimation > 1;
+	chParams	-> ctrlParams. decimation. decimationFactor	=
+	                                   decimation > 1 ? decimation : 1;
+	chParams	-> ctrlParams. decimation. wideBandSignal	= 0;
+	err =  parent -> sdrplay_api_Update (chosenDevice -> dev,
+	                                    chosenDevice -> tuner,
+	                      sdrplay_api_ReasonForUpdateT (
+	                                    sdrplay_api_Update_Dev_Fs |
+	                                    sdrplay_api_Update_Tuner_IfType |
+	                                    sdrplay_api_Update_Tuner_BwType |
+	                                    sdrplay_api_Update_Ctrl_Decimation),
+	                                    sdrplay_api_Update_Ext1_None);
+        if (err != sdrplay_api_Success) {
+           QString errorString = parent -> sdrplay_api_GetErrorString (err);
+           showState (errorString);
+	   deviceParams	-> devParams -> fsFreq. fsHz	= oldRate;
+	   chParams	-> tunerParams. ifType		= oldIf;
+	   chParams	-> tunerParams. bwType		= oldBw;
+	   chParams	-> ctrlParams. decimation	= old;
+	   return false;
+        }
+	return true;
+}
+
 int	RspDevice::get_lnaState        (int frequency, int reduction) {
 	(void)frequency; (void)reduction;
 	return 2;
@@ -60,6 +60,8 @@ virtual int	get_lnaReduction	(int frequency, int state);
 	bool	set_VFO		(int freq);
 	bool	set_SampleRate	(int samplerate);
 	bool	set_bandWidth	(int bandwidth);
+	bool	set_Mode	(int samplerate, int ifType,
+	                         int bandwidth, int decimation);
 virtual	bool	restart		(int freq);
 	bool	setAgc		(int setPoint, bool on);
 virtual	bool	setLna		(int lnaState);
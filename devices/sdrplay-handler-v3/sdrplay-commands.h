@@ -41,19 +41,41 @@
 #define GRDB_REQUEST            0110
 #define PPM_REQUEST             0111
 #define	BIAS_T_REQUEST		0112
+#define	MODE_REQUEST		0113
+//	the requests are numbered 0100 .. 0121, for the statistics
+#define	NR_REQUESTS		022
 #include	<QSemaphore>
 #include	<stdio.h>
+#include	<chrono>
+#include	<functional>
+#include	<algorithm>
+#include	<new>
+#include	<cstddef>
+#include	"bounded-queue.h"
 
+//
+//	A command is either waited for by the caller (the waiter is
+//	released when it is done), or it is asynchronous: the device
+//	thread then calls "done" with the result and returns the command
+//	to the pool it came from
 class generalCommand {
 public:
 	int	cmd;
 	bool	result;
 	QSemaphore waiter;
+	bool	async;
+	int	slotNr;
+	std::function<void (bool)> done;
+	std::chrono::steady_clock::time_point queued;
 	generalCommand (int command):
 	                waiter (0){
 	   this -> cmd = command;
+	   this -> result	= false;
+	   this -> async	= false;
+	   this -> slotNr	= -1;
 	}
 	generalCommand () {}
+virtual	~generalCommand	() {}
 };
 
 class	restartRequest: public generalCommand {
@@ -151,6 +173,29 @@ public:
 	~set_bandwidthRequest	() {}
 };
 
+//
+//	samplerate, IF, bandwidth and decimation go together, not
+//	every combination is valid
+class set_modeRequest: public generalCommand {
+public:
+	int	samplerate;
+	int	ifType;
+	int	bandwidth;
+	int	decimation;
+	int	outRate;		// the rate the client asked for
+	set_modeRequest (int samplerate, int ifType,
+	                 int bandwidth, int decimation, int outRate):
+	   generalCommand (MODE_REQUEST) {
+	   this	-> samplerate	= samplerate;
+	   this	-> ifType	= ifType;
+	   this	-> bandwidth	= bandwidth;
+	   this	-> decimation	= decimation;
+	   this	-> outRate	= outRate;
+	}
+
+	~set_modeRequest	() {}
+};
+
 class agcRequest: public generalCommand {
 public:
 	int	setPoint;
@@ -193,3 +238,65 @@ public:
 	~biasT_Request	() {}
 };
 	
+
+//
+//	The asynchronous commands are taken from a pool of preallocated
+//	slots, each large enough for any of the requests above, so
+//	issuing a command does not allocate. The free slots are kept in
+//	a lock free queue, slots are taken by the callers and returned
+//	by the device thread. Should the pool be exhausted, the command
+//	is allocated with new (and deleted when returned).
+#define	COMMAND_SLOTS	128
+
+constexpr size_t commandSlotSize	= std::max ({
+	sizeof (restartRequest), sizeof (stopRequest),
+	sizeof (lnaRequest), sizeof (antennaRequest),
+	sizeof (notch_Request), sizeof (tunerRequest),
+	sizeof (set_frequencyRequest), sizeof (set_samplerateRequest),
+	sizeof (set_bandwidthRequest), sizeof (set_modeRequest),
+	sizeof (agcRequest),
+	sizeof (GRdBRequest), sizeof (ppmRequest),
+	sizeof (biasT_Request)});
+
+class	commandPool {
+public:
+	commandPool	():
+	               freeSlots (COMMAND_SLOTS) {
+	   storage	= new slot [COMMAND_SLOTS];
+	   for (int i = 0; i < COMMAND_SLOTS; i ++)
+	      freeSlots. push (i);
+	}
+
+	~commandPool	() {
+	   delete [] storage;
+	}
+
+	template <class request, class... Args>
+	request	*get	(Args... args) {
+	static_assert (sizeof (request) <= commandSlotSize,
+	                              "request does not fit in a slot");
+	int	slotNr;
+	request	*p;
+	   if (!freeSlots. pop (slotNr))
+	      return new request (args...);
+	   p	= new (storage [slotNr]. bytes) request (args...);
+	   p	-> slotNr	= slotNr;
+	   return p;
+	}
+
+	void	put	(generalCommand *p) {
+	int	slotNr	= p -> slotNr;
+	   if (slotNr < 0) {
+	      delete p;
+	      return;
+	   }
+	   p	-> ~generalCommand ();
+	   freeSlots. push (slotNr);
+	}
+private:
+	struct slot {
+	   alignas (std::max_align_t) uint8_t bytes [commandSlotSize];
+	};
+	slot		*storage;
+	boundedQueue<int>	freeSlots;
+};
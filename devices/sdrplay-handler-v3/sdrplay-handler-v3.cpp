@@ -36,7 +36,8 @@
 //
 //	converters
 #include	"base-converter.h"
-#include	"interpolator.h"
+#include	"simd-kernels.h"
+#include	"resampler.h"
 //	The Rsp handlers
 #include	"Rsp-device.h"
 #include	"RspI-handler.h"
@@ -64,6 +65,10 @@
 #define	SDRPLAY_ANTENNA_RSP2	"Antenna_rsp2"
 #define	SDRPLAY_ANTENNA_duo	"Antenna_duo"
 #define	SDRPLAY_TUNER		"tuner"
+#define	SDRPLAY_LOW_IF		"lowIF"
+//	the largest callback the converter input is allocated for, the
+//	API delivers a few thousand samples per callback at most
+#define	MAX_CALLBACK_SIZE	16384
 
 std::string errorMessage (int errorCode) {
 	switch (errorCode) {
@@ -96,9 +101,10 @@ std::string errorMessage (int errorCode) {
 	sdrplayHandler_v3::
 	           sdrplayHandler_v3  (Server	*theServer,
 	                               QSettings *s,
-	                               RingBuffer<std::complex<uint8_t>> *b,
+	                               broadcastRing<std::complex<int16_t>> *b,
 	                               errorLogger *theLogger):
-	                                       deviceHandler (b) {
+	                                       deviceHandler (b),
+	                                       serverQueue (2 * COMMAND_SLOTS) {
 	this	-> theServer		= theServer;
 	sdrplaySettings			= s;
 	theErrorLogger			= theLogger;
@@ -112,7 +118,20 @@ std::string errorMessage (int errorCode) {
 	shifter			= 4;	// default;
 	denominator		= 2048.0f;	// default
 
-	theConverter		= new baseConverter ();
+	theConverter. store (new baseConverter ());
+	convInput. resize (MAX_CALLBACK_SIZE);	// not in the callback
+	callbackEpoch. store (0);
+	currentMode	= {KHz (2048), sdrplay_api_IF_Zero, 1, KHz (2048)};
+	rateInfo	= "IF 0 fs 2048000 dec 1 sw none";
+	cbCount. store (0);
+	cbSamples. store (0);
+	cbNanos. store (0);
+	lastCount	= 0;
+	lastSamples	= 0;
+	lastNanos	= 0;
+	lastStats	= std::chrono::steady_clock::now ();
+	lowIfLevel	= value_i (sdrplaySettings, SDRPLAY_SETTINGS,
+	                                          SDRPLAY_LOW_IF, 1);
 //	See if there are settings from previous incarnations
 //	and config stuff
 
@@ -185,14 +204,14 @@ std::string errorMessage (int errorCode) {
 #endif
 	         this, &sdrplayHandler_v3::reportOverloadState);
 
-	connect (this, &sdrplayHandler_v3::newData,
-	         theServer, &Server::newData);
 	lastFrequency	= MHz (220);
 	theGain		= -1;
 	debugControl	-> hide ();
 	failFlag. store (false);
 	successFlag. store (false);
 	errorCode	= 0;
+	for (int i = 0; i < NR_REQUESTS; i ++)
+	   latencies [i]	= {0, 0, 0};
 	start ();
 	while (!failFlag. load () && !successFlag. load () && isRunning ())
 	   usleep (1000);
@@ -203,6 +222,7 @@ std::string errorMessage (int errorCode) {
 	}
 	
 	fprintf (stderr, "setup sdrplay v3 seems successfull\n");
+	fprintf (stderr, "sample kernels: %s\n", simdLevel ());
 }
 
 	sdrplayHandler_v3::~sdrplayHandler_v3 () {
@@ -210,7 +230,15 @@ std::string errorMessage (int errorCode) {
 	while (isRunning ())
 	   usleep (1000);
 	theRsp. reset ();
-//	thread should be stopped by now
+//	thread should be stopped by now, asynchronous commands
+//	that were not executed go back to the pool
+	generalCommand *p;
+	while (serverQueue. pop (p))
+	   if (p -> async)
+	      commands. put (p);
+//	and the stream is stopped, so no callback uses the converters
+	reclaimConverters (true);
+	delete theConverter. load ();
 	myFrame. hide ();
 
 	store (sdrplaySettings, SDRPLAY_SETTINGS,
@@ -247,57 +275,50 @@ stopRequest r;
 }
 
 void	sdrplayHandler_v3::setIfGainReduction	(int GRdB) {
-GRdBRequest r (GRdB);
-	
 	if (!receiverRuns. load ())
            return;
-        messageHandler (&r);
+        asyncMessageHandler (commands. get<GRdBRequest> (GRdB));
 }
 
 void	sdrplayHandler_v3::setLnaGainReduction (int lnaState) {
-lnaRequest r (lnaState);
-
 	if (!receiverRuns. load ())
            return;
-        messageHandler (&r);
+        asyncMessageHandler (commands. get<lnaRequest> (lnaState));
 }
 
 void	sdrplayHandler_v3::setAgcControl (int dummy) {
 bool    agcMode = agcControl -> isChecked ();
-agcRequest r (agcMode, 30);
 	(void)dummy;
-        messageHandler (&r);
+        asyncMessageHandler (commands. get<agcRequest> (agcMode, 30));
 	if (agcMode) {
            GRdBSelector         -> hide ();
            gainsliderLabel      -> hide ();
 	}
 	else {
-	   GRdBRequest r2 (GRdBSelector -> value ());
 	   GRdBSelector		-> show ();
 	   gainsliderLabel	-> show ();
-	   messageHandler  (&r2);
+	   asyncMessageHandler (commands. get<GRdBRequest> (
+	                                       GRdBSelector -> value ()));
 	}
 }
 
 void	sdrplayHandler_v3::setPpmControl (int ppm) {
-ppmRequest r (ppm);
-        messageHandler (&r);
+        asyncMessageHandler (commands. get<ppmRequest> (ppm));
 }
 
 void	sdrplayHandler_v3::setBiasT (int v) {
-biasT_Request r (biasT_selector -> isChecked () ? 1 : 0);
-
 	(void)v;
-	messageHandler (&r);
+	asyncMessageHandler (commands. get<biasT_Request> (
+	                                     biasT_selector -> isChecked ()));
 	store (sdrplaySettings, SDRPLAY_SETTINGS,
 	                          SDRPLAY_BIAS_T,
 	                              biasT_selector -> isChecked () ? 1 : 0);
 }
 
 void	sdrplayHandler_v3::setNotch (int v) {
-notch_Request r (notch_selector -> isChecked () ? 1 : 0);
 	(void)v;
-	messageHandler (&r);
+	asyncMessageHandler (commands. get<notch_Request> (
+	                                     notch_selector -> isChecked ()));
 	store (sdrplaySettings, SDRPLAY_SETTINGS,
 	                           SDRPLAY_NOTCH,
 	                              notch_selector -> isChecked () ? 1 : 0);
@@ -306,8 +327,7 @@ notch_Request r (notch_selector -> isChecked () ? 1 : 0);
 void	sdrplayHandler_v3::setSelectAntenna_RSPdx	(const QString &s) {
 	uint8_t ant	= s == "Antenna A" ? 'A' :
 	                     s == "Antenna B" ? 'B' : 'C';
-	antennaRequest request (ant);
-	messageHandler (&request);
+	asyncMessageHandler (commands. get<antennaRequest> (ant));
 	store (sdrplaySettings, SDRPLAY_SETTINGS,
 	                         SDRPLAY_ANTENNA_DX, QString (QChar (ant)));
 }
@@ -315,8 +335,7 @@ void	sdrplayHandler_v3::setSelectAntenna_RSPdx	(const QString &s) {
 void	sdrplayHandler_v3::setSelectAntenna_RSP2	(const QString &s) {
 	uint8_t ant	= s == "Antenna A" ? 'A' :
 	                     s == "Antenna B" ? 'B' : 'C';
-	antennaRequest request (ant);
-	messageHandler (&request);
+	asyncMessageHandler (commands. get<antennaRequest> (ant));
 	store (sdrplaySettings, SDRPLAY_SETTINGS,
 	                         SDRPLAY_ANTENNA_RSP2, QString (QChar (ant)));
 }
@@ -324,8 +343,7 @@ void	sdrplayHandler_v3::setSelectAntenna_RSP2	(const QString &s) {
 //	Not used:
 void	sdrplayHandler_v3::setSelectAntenna_duo	(const QString &s) {
 	uint8_t ant	= s == "Antenna A" ? 'A' : 'B';
-	antennaRequest request (ant);
-	messageHandler (&request);
+	asyncMessageHandler (commands. get<antennaRequest> (ant));
 	store (sdrplaySettings, SDRPLAY_SETTINGS,
 	                          SDRPLAY_ANTENNA_duo, QString (QChar (ant)));
 }
@@ -338,7 +356,7 @@ void	sdrplayHandler_v3::setSelectTuner	(const QString &s) {
 	else
 	   biasT_selector -> show ();
 
-	messageHandler (new tunerRequest (tuner));
+	asyncMessageHandler (commands. get<tunerRequest> (tuner));
 
 	store (sdrplaySettings, SDRPLAY_SETTINGS, SDRPLAY_TUNER, tuner);
 }
@@ -360,29 +378,80 @@ QString	sdrplayHandler_v3::deviceName	() {
 void	sdrplayHandler_v3::tcp_setFrequency        (int newFreq) {
         if (!receiverRuns. load ())
            return;
-	set_frequencyRequest r (newFreq);
 	lastFrequency    = newFreq;
 	_I_Buffer ->  FlushRingBuffer();
-	messageHandler (&r);
+	asyncMessageHandler (commands. get<set_frequencyRequest> (newFreq));
 }
 
-void	sdrplayHandler_v3::tcp_setSampleRate       (int samplerate) {
-        if (!receiverRuns. load ())
+//
+//	The device delivers a rate at or above the requested one (see
+//	selectMode), the resampler does the rest.
+//	The device thread changes the converter when the device runs in
+//	the new mode, if that fails the device and the converter stay in
+//	the old one. "done" is then called (in the device thread) with
+//	the result
+void	sdrplayHandler_v3::tcp_setSampleRate       (int samplerate,
+	                                 std::function<void (bool)> done) {
+deviceMode	m	= selectMode (samplerate);
+        if (!receiverRuns. load ()) {
+	   if (done)
+	      done (false);
            return;
-	if (samplerate >= 2000000) {
-	   set_samplerateRequest r1 (samplerate);
-	   messageHandler (&r1);
-	   set_bandwidthRequest r2 (getBandwidth ((int)samplerate));
-	   messageHandler (&r2);
-	   set_converter (samplerate, samplerate);
 	}
-	else {
-	   set_samplerateRequest r1 (2000000);
-	   messageHandler (&r1);
-	   set_bandwidthRequest r2 (getBandwidth ((int)samplerate));
-	   messageHandler (&r2);
-	   set_converter (2000000, samplerate);
+	asyncMessageHandler (commands. get<set_modeRequest> (m. fs,
+	                                 m. ifType,
+	                                 getBandwidth (samplerate, m. ifType),
+	                                 m. decimation, samplerate),
+	                     std::move (done));
+}
+//
+//	In zero IF mode the device runs at the requested rate, or, below
+//	2 MS/s, at 2 MS/s with the largest hardware decimation (a power
+//	of two, up to 32) that keeps the rate at or above the requested one.
+//	The low IF modes have no DC spike. The API itself shifts the IF
+//	to zero and decimates by 4, so they deliver fs / 4, the hardware
+//	decimator is not used on top of that. The 450k IF runs the ADC
+//	at 2 MS/s as zero IF does, the other two run it (and the USB) at
+//	6 and 8.192 MS/s, so they are only used on request (lowIfLevel 2)
+struct lowIfMode {
+	int	fs;
+	int	ifType;
+};
+
+static
+const lowIfMode lowIfModes [] = {
+	{KHz (2000), sdrplay_api_IF_0_450},
+	{KHz (6000), sdrplay_api_IF_1_620},
+	{KHz (8192), sdrplay_api_IF_2_048}
+};
+
+static
+int	outputRate	(int fs, int ifType, int decimation) {
+	if (ifType != sdrplay_api_IF_Zero)
+	   return fs / 4;
+	return fs / decimation;
+}
+
+deviceMode	sdrplayHandler_v3::selectMode	(int samplerate) {
+deviceMode m	= {samplerate >= MHz (2) ? samplerate : MHz (2),
+	           sdrplay_api_IF_Zero, 1, 0};
+	while ((m. decimation < 32) &&
+	              (m. fs / (2 * m. decimation) >= samplerate))
+	   m. decimation *= 2;
+	m. outRate	= outputRate (m. fs, m. ifType, m. decimation);
+	if ((samplerate >= MHz (2)) || (lowIfLevel <= 0))
+	   return m;
+	for (auto &l : lowIfModes) {
+	   int outRate	= outputRate (l. fs, l. ifType, 1);
+	   if ((l. ifType != sdrplay_api_IF_0_450) && (lowIfLevel < 2))
+	      continue;
+	   if (outRate < samplerate)
+	      continue;
+	   if ((lowIfLevel >= 2) || (outRate <= m. outRate))
+	      return {l. fs, l. ifType, 1, outRate};
+	   break;
 	}
+	return m;
 }
 
 void	sdrplayHandler_v3::tcp_setGainMode         (bool b) {
@@ -398,8 +467,7 @@ void	sdrplayHandler_v3::tcp_setAgc		(int v) {
 	connect (agcControl, &QCheckBox::checkStateChanged,
 	            this, &sdrplayHandler_v3::setAgcControl);
 //	GRdBSelector	-> setEnabled (v == 1);
-	agcRequest r (v != 1, -30);
-	messageHandler (&r);
+	asyncMessageHandler (commands. get<agcRequest> (v != 1, -30));
 }
 
 void	sdrplayHandler_v3::tcp_setGain		(int gain) {
@@ -419,24 +487,20 @@ void	sdrplayHandler_v3::tcp_setGain		(int gain) {
 	lnaGainSetting	-> setValue (lnaState);
 	connect (lnaGainSetting, qOverload<int>(&QSpinBox::valueChanged),
 	         this, &sdrplayHandler_v3::setLnaGainReduction);
-	GRdBRequest r1 (GRdB);
-	messageHandler (&r1);
-	lnaRequest r2 (lnaState);
-	messageHandler (&r2);
+	asyncMessageHandler (commands. get<GRdBRequest> (GRdB));
+	asyncMessageHandler (commands. get<lnaRequest> (lnaState));
 }
 
 void	sdrplayHandler_v3::tcp_setPpm		(int ppm) {
 	if (!receiverRuns. load ())
 	   return;
-	ppmRequest r (ppm);
-	messageHandler (&r);
+	asyncMessageHandler (commands. get<ppmRequest> (ppm));
 }
 
 void	sdrplayHandler_v3::tcp_setBiasT            (bool b) {
 	if (!receiverRuns. load ())
 	   return;
-	biasT_Request r (b);
-	messageHandler (&r);
+	asyncMessageHandler (commands. get<biasT_Request> (b));
 }
 
 ///////////////////////////////////////////////////////////////////////////
@@ -445,7 +509,8 @@ void	sdrplayHandler_v3::tcp_setBiasT            (bool b) {
 //
 //	Since the daemon is not threadproof, we have to package the
 //	actual interface into its own thread.
-//	Communication with that thread is synchronous!
+//	Starting and stopping is synchronous, the other commands
+//	are asynchronous, the caller does not wait for sdrplay_api_Update
 //
 
 void	sdrplayHandler_v3::setLnaBounds (int low, int high) {
@@ -518,14 +583,200 @@ int	ind	= -1;
 //	the real controller starts here
 ///////////////////////////////////////////////////////////////////////
 
-bool    sdrplayHandler_v3::messageHandler (generalCommand *r) {
-        serverQueue. push (r);
+//
+//	The queue is lock free and bounded, the device thread is the
+//	only reader
+bool	sdrplayHandler_v3::queueCommand	(generalCommand *r) {
+	r -> queued	= std::chrono::steady_clock::now ();
+        if (!serverQueue. push (r))
+	   return false;
 	serverJobs. release (1);
+	return true;
+}
+//
+//	the synchronous call: the caller waits until the device
+//	thread executed the command
+bool    sdrplayHandler_v3::messageHandler (generalCommand *r) {
+	r -> async	= false;
+	if (!queueCommand (r))
+	   return false;
 	while (!r -> waiter. tryAcquire (1, 1000))
 	   if (!threadRuns. load ())
 	      return false;
 	return true;
 }
+//
+//	the asynchronous call returns immediately, the command - which
+//	must be taken from the pool - is returned by the device thread,
+//	after calling "done" (in the device thread!) with the result.
+//	If the queue is full, "done" is called here with false
+void	sdrplayHandler_v3::asyncMessageHandler	(generalCommand *r,
+	                                 std::function<void (bool)> done) {
+	r -> async	= true;
+	r -> done	= done;
+	if (!queueCommand (r)) {
+	   fprintf (stderr, "command queue full, command %o lost\n",
+	                                                     r -> cmd);
+	   if (r -> done)		// the caller learns it failed
+	      r -> done (false);
+	   commands. put (r);
+	}
+}
+//
+//	executed in the device thread
+void	sdrplayHandler_v3::executeCommand	(generalCommand *p) {
+bool	result	= false;
+	switch (p -> cmd) {
+	   case RESTART_REQUEST:
+	      result = theRsp -> restart (((restartRequest *)p) -> freq);
+	      receiverRuns. store (true);
+	      break;
+
+	   case STOP_REQUEST:
+	      receiverRuns. store (false);
+	      result	= true;
+	      break;
+
+	   case SETFREQUENCY_REQUEST:
+	      result = theRsp -> set_VFO (((set_frequencyRequest *)p) -> newFreq);
+	      break;
+
+	   case SAMPLERATE_REQUEST:
+	      result = theRsp -> set_SampleRate (
+	                          ((set_samplerateRequest *)p) -> samplerate);
+	      receiverRuns. store (true);
+	      break;
+
+	   case MODE_REQUEST: {
+	      set_modeRequest *r = (set_modeRequest *)p;
+	      result = theRsp -> set_Mode (r -> samplerate, r -> ifType,
+	                                   r -> bandwidth, r -> decimation);
+	      if (result) {
+	         currentMode = {r -> samplerate, r -> ifType, r -> decimation,
+	                        outputRate (r -> samplerate, r -> ifType,
+	                                    r -> decimation)};
+	         set_converter (currentMode. outRate, r -> outRate);
+	      }
+	      receiverRuns. store (true);
+	      break;
+	   }
+
+	   case BANDWIDTH_REQUEST:
+	      result = theRsp -> set_bandWidth (
+	                          ((set_bandwidthRequest *)p) -> bandwidth);
+	      receiverRuns. store (true);
+	      break;
+
+	   case AGC_REQUEST: {
+	      agcRequest *r = (agcRequest *)p;
+	      result = theRsp -> setAgc (-r -> setPoint, r -> agcMode);
+	      break;
+	   }
+
+	   case GRDB_REQUEST:
+	      result = theRsp -> setGRdB (((GRdBRequest *)p) -> GRdBValue);
+	      break;
+
+	   case PPM_REQUEST:
+	      result = theRsp -> setPpm (((ppmRequest *)p) -> ppmValue);
+	      break;
+
+	   case LNA_REQUEST:
+	      result = theRsp -> setLna (((lnaRequest *)p) -> lnaState);
+	      break;
+
+	   case ANTENNASELECT_REQUEST:
+	      result = theRsp -> setAntenna (((antennaRequest *)p) -> antenna);
+	      break;
+
+	   case BIAS_T_REQUEST:
+	      result = theRsp -> setBiasT (((biasT_Request *)p) -> checked);
+	      break;
+
+	   case NOTCH_REQUEST:
+	      result = theRsp -> setNotch (((notch_Request *)p) -> checked);
+	      break;
+
+	   case TUNERSELECT_REQUEST:
+	      result = theRsp -> setTuner (((tunerRequest *)p) -> tuner);
+	      break;
+
+	   default:		// cannot happen
+	      fprintf (stderr, "Helemaal fout\n");
+	      break;
+	}
+	p -> result	= result;
+
+	uint64_t latency = std::chrono::duration_cast<std::chrono::microseconds>
+	                    (std::chrono::steady_clock::now () - p -> queued).
+	                                                          count ();
+	if ((p -> cmd >= 0100) && (p -> cmd < 0100 + NR_REQUESTS)) {
+	   std::lock_guard<std::mutex> lock (statsLocker);
+	   commandStats &s = latencies [p -> cmd - 0100];
+	   s. count ++;
+	   s. total	+= latency;
+	   if (latency > s. max)
+	      s. max	= latency;
+	}
+
+	if (p -> async) {
+	   if (p -> done)
+	      p -> done (result);
+	   commands. put (p);
+	}
+	else
+	   p -> waiter. release (1);
+}
+
+//
+//	the rate conversion, the callbacks per second with the samples
+//	they deliver and the fraction of the time spent in them, and
+//	for each request type that was used: the nr of commands, and
+//	the mean and maximum latency in msec
+QString	sdrplayHandler_v3::commandStatistics	() {
+static
+const char *names [NR_REQUESTS] = {
+	"restart", "stop", "lna", "antenna", "freq", "rate", "bw", "agc",
+	"grdb", "ppm", "biasT", "mode", "", "", "", "", "notch", "tuner"};
+QString	res;
+std::chrono::steady_clock::time_point now =
+	                          std::chrono::steady_clock::now ();
+double	elapsed	= std::chrono::duration<double> (now - lastStats). count ();
+uint64_t count	= cbCount. load ();
+uint64_t samples = cbSamples. load ();
+uint64_t nanos	= cbNanos. load ();
+	{  std::lock_guard<std::mutex> lock (converterLocker);
+	   res	= rateInfo + " ";
+	}
+	if (elapsed > 0) {
+	   res	+= "cb " + QString::number ((count - lastCount) / elapsed,
+	                                                        'f', 0) +
+	           "/s " +
+	           QString::number ((samples - lastSamples) / elapsed,
+	                                                        'f', 0) +
+	           " S/s load " +
+	           QString::number ((nanos - lastNanos) / elapsed / 1.0e7,
+	                                                        'f', 2) +
+	           "% ";
+	}
+	lastStats	= now;
+	lastCount	= count;
+	lastSamples	= samples;
+	lastNanos	= nanos;
+	std::lock_guard<std::mutex> lock (statsLocker);
+	for (int i = 0; i < NR_REQUESTS; i ++) {
+	   if (latencies [i]. count == 0)
+	      continue;
+	   res	+= QString (names [i]) + " " +
+	           QString::number ((qulonglong)(latencies [i]. count)) + "x " +
+	           QString::number (latencies [i]. total /
+	                             latencies [i]. count / 1000.0, 'f', 1) +
+	           "/" +
+	           QString::number (latencies [i]. max / 1000.0, 'f', 1) +
+	           "ms ";
+	}
+	return res;
+}
 
 static
 void    StreamACallback (short *xi, short *xq,
@@ -534,7 +785,6 @@ void    StreamACallback (short *xi, short *xq,
 	                 unsigned int reset,
                          void *cbContext) {
 sdrplayHandler_v3 *p	= static_cast<sdrplayHandler_v3 *> (cbContext);
-std::complex<int16_t> localBuf [numSamples];
 
 	(void)params;
 	if (reset)
@@ -542,11 +792,7 @@ std::complex<int16_t> localBuf [numSamples];
 	if (!p -> receiverRuns. load ())
 	   return;
 
-	for (int i = 0; i <  (int)numSamples; i ++) {
-	   std::complex<int16_t> symb = std::complex<int16_t> (xi [i], xq [i]);
-	   localBuf [i] = symb;
-	}
-	p -> processBuffer (localBuf, numSamples);
+	p -> processBuffer (xi, xq, numSamples);
 }
 
 static
@@ -877,126 +1123,9 @@ int	deviceIndex	= 0;
 	   if (!threadRuns. load ())
 	      goto normal_exit;
 
-//	here we could assert that the serverQueue is not empty
-//	Note that we emulate synchronous calling, so
-//	we signal the caller when we are done
-	   switch (serverQueue. front () -> cmd) {
-	      case RESTART_REQUEST: {
-	         restartRequest *p = (restartRequest *)(serverQueue. front ());
-	         serverQueue. pop ();
-	         p -> result = theRsp -> restart (p -> freq);
-	         receiverRuns. store (true);
-	         p -> waiter. release (1);
-	         break;
-	      }
-	       
-	      case STOP_REQUEST: {
-	         stopRequest *p = (stopRequest *)(serverQueue. front ());
-	         serverQueue. pop ();
-	         receiverRuns. store (false);
-	         p -> waiter. release (1);
-	         break;
-	      }
-	       
-	      case SETFREQUENCY_REQUEST: {
-	         set_frequencyRequest *p =
-	               (set_frequencyRequest *)(serverQueue. front ());
-	         serverQueue. pop ();
-	         p -> result = theRsp -> set_VFO (p -> newFreq);
-	         p -> waiter. release (1);
-	         break;
-	      }
-
-	      case SAMPLERATE_REQUEST: {
-	         set_samplerateRequest *p =
-	               (set_samplerateRequest *)(serverQueue. front ());
-	         serverQueue. pop ();
-	         p -> result = theRsp -> set_SampleRate (p -> samplerate);
-	         receiverRuns. store (true);
-	         p -> waiter. release (1);
-	         break;
-	      }
-
-	      case BANDWIDTH_REQUEST: {
-	         set_bandwidthRequest *p =
-	               (set_bandwidthRequest *)(serverQueue. front ());
-	         serverQueue. pop ();
-	         p -> result = theRsp -> set_bandWidth (p -> bandwidth);
-	         receiverRuns. store (true);
-	         p -> waiter. release (1);
-	         break;
-	      }
-
-	      case AGC_REQUEST: {
-	         agcRequest *p = 
-	                    (agcRequest *)(serverQueue. front ());
-	         serverQueue. pop ();
-	         p -> result = theRsp -> setAgc (-p -> setPoint, p -> agcMode);
-	         p -> waiter. release (1);
-	         break;
-	      }
-
-	      case GRDB_REQUEST: {
-	         GRdBRequest *p =  (GRdBRequest *)(serverQueue. front ());
-	         serverQueue. pop ();
-	         p -> result = theRsp -> setGRdB (p -> GRdBValue);
-                 p -> waiter. release (1);
-	         break;
-	      }
-
-	      case PPM_REQUEST: {
-	         ppmRequest *p = (ppmRequest *)(serverQueue. front ());
-	         serverQueue. pop ();
-	         p -> result = theRsp -> setPpm (p -> ppmValue);
-	         p -> waiter. release (1);
-	         break;
-	      }
-
-	      case LNA_REQUEST: {
-	         lnaRequest *p = (lnaRequest *)(serverQueue. front ());
-	         serverQueue. pop ();
-	         p -> result = theRsp -> setLna (p -> lnaState);
-                 p -> waiter. release (1);
-	         break;
-	      }
-
-	      case ANTENNASELECT_REQUEST: {
-	         antennaRequest *p = (antennaRequest *)(serverQueue. front ());
-	         serverQueue. pop ();
-	         p -> result = theRsp -> setAntenna (p -> antenna);
-                 p -> waiter. release (1);
-	         break;
-	      }
-
-	      case BIAS_T_REQUEST: {
-	         biasT_Request *p = (biasT_Request *)(serverQueue. front ());
-	         serverQueue. pop ();
-	         p -> result = theRsp -> setBiasT (p -> checked);
-                 p -> waiter. release (1);
-	         break;
-	      }
-
-	      case NOTCH_REQUEST: {
-	         notch_Request *p = (notch_Request *)(serverQueue. front ());
-	         serverQueue. pop ();
-	         p -> result = theRsp -> setNotch (p -> checked);
-                 p -> waiter. release (1);
-	         break;
-	      }
-
-	      case TUNERSELECT_REQUEST: {
-	         tunerRequest *p =
-	               (tunerRequest *)(serverQueue. front ());
-	         serverQueue. pop();
-	         p -> result = theRsp -> setTuner (p -> tuner);
-	         p -> waiter. release (1);
-	         break;
-	      }
-
-	      default:		// cannot happen
-	         fprintf (stderr, "Helemaal fout\n");
-	         break;
-	   }
+	   generalCommand *p;
+	   if (serverQueue. pop (p))
+	      executeCommand (p);
 	}
 
 
@@ -1276,41 +1405,64 @@ void	sdrplayHandler_v3::enableBiasT (bool b) {
 	  biasT_selector -> hide ();
 }
 
-uint8_t	from_int16_to_uint8 (int16_t in, int nrBits) {
-uint8_t result;
-int shifter	= nrBits - 7;
-	if (in >= 0) {
-	   in >>= shifter;
-	   result = in & 0X7F;
-	   result += 128;
+//
+//	the samples are stored as they are, i.e. nrBits bits values,
+//	the conversion to what the clients want is done in the handler
+//
+//	The samples go straight into the regions of the ring buffer
+//	returned by GetRingBufferWriteRegions, and are published with
+//	AdvanceRingBufferWriteIndex, there are no intermediate copies.
+//	Without rate conversion the planar I and Q are interleaved into
+//	the buffer, otherwise the converter writes its output block
+//	into the first and then the second region (one virtual call
+//	per region, not per sample). What does not fit is lost, as is
+//	what a callback delivers beyond MAX_CALLBACK_SIZE samples when
+//	converting: the callback never allocates.
+void	sdrplayHandler_v3::processBuffer (const int16_t *xi,
+	                                  const int16_t *xq, int size) {
+void	*data1, *data2;
+int32_t	size1, size2;
+int	room;
+int	teller	= 0;
+int	used, n1, n2;
+std::complex<int16_t> *region1;
+std::complex<int16_t> *region2;
+baseConverter	*converter;
+std::chrono::steady_clock::time_point start =
+	                           std::chrono::steady_clock::now ();
+	callbackEpoch. fetch_add (1);		// odd, we are in
+	converter	= theConverter. load ();
+	room	= _I_Buffer -> GetRingBufferWriteRegions (size,
+	                                                  &data1, &size1,
+	                                                  &data2, &size2);
+	region1	= (std::complex<int16_t> *)data1;
+	region2	= (std::complex<int16_t> *)data2;
+	if (!converter -> changesRate ()) {
+	   interleaveSamples (xi, xq, size1, region1);
+	   if (size2 > 0)
+	      interleaveSamples (xi + size1, xq + size1, size2, region2);
+	   teller	= room;
 	}
 	else {
-	   in = -in;
-	   in >>= shifter;
-	   result = -in & 0x7F;
-	}
-	return result;
-}
-	   
-void	sdrplayHandler_v3::processBuffer (std::complex<int16_t> *b, int size) {
-std::complex<uint8_t> buffer [size];
-int	teller	= 0;
-	locker. lock ();
-	if (theConverter != nullptr) {		// should not/ cannot happen
-	   for (int i = 0; i < size; i ++)  {
-	      std::complex<int16_t> y = b [i];
-	      if (theConverter -> process (y, y)) {
-	         std::complex<uint8_t> x = std::complex<uint8_t> (
-	                         from_int16_to_uint8 (real (y), nrBits),
-	                         from_int16_to_uint8 (imag (y), nrBits));
-	         buffer [teller ++] = x;
-	      }
+	   if (size > (int)convInput. size ())
+	      size	= convInput. size ();
+	   interleaveSamples (xi, xq, size, convInput. data ());
+	   used	= converter -> process (convInput. data (), size,
+	                                   region1, size1, n1);
+	   teller	= n1;
+	   if (size2 > 0) {
+	      converter -> process (convInput. data () + used, size - used,
+	                            region2, size2, n2);
+	      teller	+= n2;
 	   }
-	   _I_Buffer ->  putDataIntoBuffer (buffer, teller);
 	}
-	locker. unlock ();
-	if (_I_Buffer -> GetRingBufferReadAvailable () >= 2048)
-	   newData (2049);
+	_I_Buffer -> AdvanceRingBufferWriteIndex (teller);
+	callbackEpoch. fetch_add (1);		// even, we are out
+	dataAvailable ();
+	cbNanos. fetch_add (std::chrono::duration_cast<std::chrono::nanoseconds>
+	                   (std::chrono::steady_clock::now () - start). count ());
+	cbSamples. fetch_add (size);
+	cbCount. fetch_add (1);
 }
 //
 //	we have to simulate a reasonable gain value (not gainreduction)
@@ -1344,7 +1496,14 @@ void	sdrplayHandler_v3::computeGain (int frequency, int gainValue,
 	}
 }
 
-sdrplay_api_Bw_MHzT	sdrplayHandler_v3::getBandwidth	(int samplerate) {
+//
+//	The 1620k and 2048k IF's only go with 1.536 MHz, the 450k IF
+//	with 600k and less, which is what the lower rates get anyway
+sdrplay_api_Bw_MHzT	sdrplayHandler_v3::getBandwidth	(int samplerate,
+	                                                 int ifType) {
+	if ((ifType == sdrplay_api_IF_1_620) ||
+	                           (ifType == sdrplay_api_IF_2_048))
+	   return sdrplay_api_BW_1_536;
 	if (samplerate >= MHz (8))
 	   return sdrplay_api_BW_8_000;
 	if (samplerate >= MHz (7))
@@ -1362,18 +1521,53 @@ sdrplay_api_Bw_MHzT	sdrplayHandler_v3::getBandwidth	(int samplerate) {
 	return sdrplay_api_BW_0_200;
 }
 
+//
+//	Called from the device thread, never from the callback. The new
+//	converter is built here and published with an atomic swap, the
+//	callback never waits
 void	sdrplayHandler_v3::set_converter (int inrate, int outrate) {
-	locker. lock ();
-	if (theConverter != nullptr)
-	   delete theConverter;
-	if (inrate == outrate) {
-	  theConverter	= new baseConverter ();
-	  locker. unlock ();
-	   return;
+baseConverter	*newConverter;
+baseConverter	*oldConverter;
+//	we know that outrate <= inrate, the filters of the resampler
+//	come from a cache, so this is cheap
+	if (inrate == outrate)
+	   newConverter	= new baseConverter ();
+	else
+	   newConverter	= new resampler (inrate, outrate);
+
+	std::lock_guard<std::mutex> lock (converterLocker);
+	rateInfo	= "IF " + QString::number (currentMode. ifType) +
+	                  " fs " + QString::number (currentMode. fs) +
+	                  " dec " + QString::number (currentMode. decimation);
+	if (inrate == outrate)
+	   rateInfo	+= " sw none";
+	else
+	   rateInfo	+= " sw resample " +
+	                   QString::number (inrate) + "->" +
+	                   QString::number (outrate) + " (" +
+	                   QString::number (((resampler *)newConverter) ->
+	                                          nrHalfbands ()) +
+	                   " halfbands)";
+	oldConverter	= theConverter. exchange (newConverter);
+//	a callback that started before the swap may still use the old one,
+//	a callback that starts after the swap uses the new one
+	retired. push_back (std::pair<baseConverter *, uint64_t>
+	                           (oldConverter, callbackEpoch. load ()));
+	reclaimConverters (false);
+}
+//
+//	An old converter can go if no callback was running at the swap
+//	(even epoch), or the callback running then has finished (the
+//	epoch changed). With "all" set the stream is stopped
+void	sdrplayHandler_v3::reclaimConverters	(bool all) {
+uint64_t now	= callbackEpoch. load ();
+	for (auto it = retired. begin (); it != retired. end ();) {
+	   if (all || ((it -> second & 01) == 0) || (it -> second != now)) {
+	      delete it -> first;
+	      it	= retired. erase (it);
+	   }
+	   else
+	      it ++;
 	}
-//	we know that outrate < inrate now
-//	for no, we just use filtering and interpolation
-	theConverter	= new interpolator (inrate, outrate);
-	locker. unlock ();
 }
 	
@@ -29,8 +29,9 @@
 #include	<atomic>
 #include	<complex>
 #include	<stdio.h>
-#include	<queue>
-#include	"ringbuffer.h"
+#include	<functional>
+#include	<vector>
+#include	"broadcast-ring.h"
 #include	"device-handler.h"
 #include	"ui_sdrplay-widget-v3.h"
 #include	<sdrplay_api.h>
@@ -38,6 +39,7 @@
 #include	<mutex>
 #include	<QScopedPointer>
 #include	"Rsp-device.h"
+#include	"sdrplay-commands.h"
 
 class		baseConverter;
 #ifndef	KHz
@@ -47,7 +49,6 @@ class		baseConverter;
 #define	MHz(x)	(1000 * KHz (x))
 #endif
 
-class	generalCommand;
 class	xml_fileWriter;
 class	errorLogger;
 #include        "dlfcn.h"
@@ -61,6 +62,15 @@ typedef void    *HINSTANCE;
 #endif
 
 class Server;
+//
+//	the way the device delivers a samplerate: the rate of the ADC,
+//	the IF, the hardware decimation and the resulting rate
+struct deviceMode {
+	int	fs;
+	int	ifType;
+	int	decimation;
+	int	outRate;
+};
 
 class	sdrplayHandler_v3 final:
 	           public deviceHandler, public Ui_sdrplayWidget_v3 {
@@ -68,7 +78,7 @@ Q_OBJECT
 public:
 			sdrplayHandler_v3	(Server *,
 	                                         QSettings *,
-	                                         RingBuffer<std::complex<uint8_t>> *,
+	                                         broadcastRing<std::complex<int16_t>> *,
 	                                         errorLogger *);
 			~sdrplayHandler_v3	();
 
@@ -79,12 +89,14 @@ public:
 	QString		deviceName		();
 
 	void		tcp_setFrequency	(int);
-	void		tcp_setSampleRate	(int);
+	void		tcp_setSampleRate	(int,
+	                                 std::function<void (bool)>);
 	void		tcp_setGainMode		(bool);
 	void		tcp_setGain		(int);
 	void		tcp_setAgc		(int);
 	void		tcp_setPpm		(int);
 	void		tcp_setBiasT		(bool);
+	QString		commandStatistics	();
 
 	void            updatePowerOverload (
 	                                 sdrplay_api_EventParamsT *params);
@@ -92,7 +104,8 @@ public:
 	int		theGain;
 	int		shifter;
 	sdrplay_api_CallbackFnsT	cbFns;
-	void		processBuffer	(std::complex<int16_t> *, int);
+	void		processBuffer	(const int16_t *,
+	                                 const int16_t *, int);
 
 private:
 public:
@@ -126,6 +139,21 @@ public:
 	std::atomic<bool>       threadRuns;
 	void			run			();
 	bool			messageHandler		(generalCommand *);
+	void			asyncMessageHandler	(generalCommand *,
+	                                   std::function<void (bool)> done =
+	                                                          nullptr);
+	bool			queueCommand		(generalCommand *);
+	void			executeCommand		(generalCommand *);
+//
+//	per request type the nr of commands, the total and the maximum
+//	time between queueing and completion, in usec
+	struct commandStats {
+	   uint64_t	count;
+	   uint64_t	total;
+	   uint64_t	max;
+	};
+	commandStats		latencies [NR_REQUESTS];
+	std::mutex		statsLocker;
 
 	QString			recorderVersion;
 	
@@ -142,7 +170,8 @@ public:
 	HINSTANCE		Handle;
 	double			ppmValue;
 	bool			biasT;
-	std::queue<generalCommand *>	serverQueue;
+	boundedQueue<generalCommand *>	serverQueue;
+	commandPool		commands;
 	QSemaphore		serverJobs;
 	HINSTANCE               fetchLibrary            ();
 	void                    releaseLibrary          ();
@@ -152,10 +181,39 @@ public:
 
 	void			computeGain		(int, int,
 	                                                 int &, int &);
-	sdrplay_api_Bw_MHzT	getBandwidth		(int);
-	std::mutex		locker;
-	baseConverter		*theConverter;
+	sdrplay_api_Bw_MHzT	getBandwidth		(int, int);
+//
+//	0: zero IF only, 1: low IF (450k) where it does not cost more
+//	than zero IF, 2: low IF wherever it exists
+	int			lowIfLevel;
+	deviceMode		selectMode		(int);
+//
+//	The converter is used by the callback without locking: a new
+//	one is published with an atomic swap, the old one is kept in
+//	"retired" until the callback is known to be done with it.
+//	callbackEpoch is incremented on entering and on leaving
+//	processBuffer, so it is odd while the callback runs
+	std::atomic<baseConverter *>	theConverter;
+	std::atomic<uint64_t>	callbackEpoch;
+	std::vector<std::pair<baseConverter *, uint64_t>> retired;
+	std::mutex		converterLocker;
+	std::vector<std::complex<int16_t>>	convInput;
+//	the mode the device runs in, only touched by the
+//	device thread, and a description of the rate conversion
+	deviceMode		currentMode;
+	QString			rateInfo;
+//
+//	the time spent in the callback, and the state at the previous
+//	statistics call
+	std::atomic<uint64_t>	cbCount;
+	std::atomic<uint64_t>	cbSamples;
+	std::atomic<uint64_t>	cbNanos;
+	uint64_t		lastCount;
+	uint64_t		lastSamples;
+	uint64_t		lastNanos;
+	std::chrono::steady_clock::time_point lastStats;
 	void			set_converter		(int, int);
+	void			reclaimConverters	(bool all);
 signals:
 	void			newGRdBValue		(int);
 	void			newLnaValue		(int);
@@ -190,7 +248,5 @@ signals:
 	void			setApiVersionSignal	(float);
 	void			setAntennaSelectSignal	(bool);
 	void			overloadStateChanged	(bool);
-
-	void			newData			(int);
 };
 
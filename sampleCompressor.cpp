@@ -0,0 +1,149 @@
+#
+/*
+ *    Copyright (C)  2025
+ *    Jan van Katwijk (J.vanKatwijk@gmail.com)
+ *    Lazy Chair Computing
+ *
+ *    This file is part of the sdrplayServer
+ *
+ *    sdrplayServerr is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    sdrplayServer is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with sdrplayServerr; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include	"sampleCompressor.h"
+#include	"rice-coder.h"
+#include	<chrono>
+//
+//	the input buffer takes about 8 blocks, the output buffer
+//	the frames for the same amount of samples, uncompressed
+	sampleCompressor::sampleCompressor	(int blockSize, int loss):
+	                                    inBuffer (8 * blockSize),
+	                                    outBuffer (8 * maxFrameSize (blockSize)),
+	                                    block (blockSize),
+	                                    work (4 * blockSize),
+	                                    frame (maxFrameSize (blockSize)) {
+	this	-> blockSize	= blockSize;
+	this	-> loss		= loss;
+	nrBits. store (12);
+	frameNotifier. store (nullptr);
+	lastRatio. store (0);
+	lastEncodeTime. store (0);
+	nrBlocks. store (0);
+	bytesIn. store (0);
+	bytesOut. store (0);
+	nrDropped. store (0);
+	running. store (false);
+	start ();
+}
+
+	sampleCompressor::~sampleCompressor	() {
+	stop ();
+}
+
+void	sampleCompressor::stop	() {
+	running. store (false);
+	while (isRunning ())
+	   usleep (1000);
+}
+
+void	sampleCompressor::setBitDepth	(int nrBits) {
+	this	-> nrBits. store (nrBits);
+}
+//
+//	the streamer is told when a frame is ready
+void	sampleCompressor::setNotifier	(sampleNotifier *n) {
+	frameNotifier. store (n);
+}
+//
+//	called from the streamer's thread. If the compressor cannot
+//	keep up, the samples are lost for the compressed stream only
+void	sampleCompressor::newData	(const std::complex<int16_t> *v,
+	                                                     int size) {
+int	written	= inBuffer. putDataIntoBuffer (v, size);
+	if (written < size)
+	   nrDropped. fetch_add (size - written);
+	if (inBuffer. GetRingBufferReadAvailable () >= (uint32_t)blockSize)
+	   dataNotifier. notify ();
+}
+//
+//	called from the streamer's thread, a frame is only
+//	taken when it is completely there
+bool	sampleCompressor::nextFrame	(std::vector<uint8_t> &frame) {
+uint8_t	header [FRAME_HEADER_SIZE];
+void	*data1, *data2;
+int32_t	size1, size2;
+int	available	= outBuffer. GetRingBufferReadAvailable ();
+	if (available < FRAME_HEADER_SIZE)
+	   return false;
+	outBuffer. GetRingBufferReadRegions (FRAME_HEADER_SIZE,
+	                                     &data1, &size1, &data2, &size2);
+	memcpy (header, data1, size1);
+	if (size2 > 0)
+	   memcpy (&header [size1], data2, size2);
+	int size	= FRAME_HEADER_SIZE +
+	          ((header [6] << 24) | (header [7] << 16) |
+	           (header [8] << 8) | header [9]);
+	if (available < size)
+	   return false;
+	frame. resize (size);
+	outBuffer. getDataFromBuffer (frame. data (), size);
+	return true;
+}
+
+void	sampleCompressor::run	() {
+	running. store (true);
+	while (running. load ()) {
+	   dataNotifier. wait (50);
+	   while (inBuffer. GetRingBufferReadAvailable () >=
+	                                        (uint32_t)blockSize) {
+	      inBuffer. getDataFromBuffer (block. data (), blockSize);
+	      auto start	= std::chrono::steady_clock::now ();
+	      int size	= encodeFrame (block. data (), blockSize,
+	                               nrBits. load (), loss, frame. data (),
+	                               work. data ());
+	      auto stop	= std::chrono::steady_clock::now ();
+	      lastEncodeTime. store (std::chrono::duration_cast<
+	                               std::chrono::microseconds> (stop - start).
+	                                                            count ());
+	      lastRatio. store ((float)(4 * blockSize) / size);
+	      nrBlocks. fetch_add (1);
+	      bytesIn. fetch_add (4 * blockSize);
+	      if (outBuffer. GetRingBufferWriteAvailable () < (uint32_t)size) {
+	         nrDropped. fetch_add (blockSize);
+	         continue;
+	      }
+	      outBuffer. putDataIntoBuffer (frame. data (), size);
+	      bytesOut. fetch_add (size);
+	      sampleNotifier *n = frameNotifier. load ();
+	      if (n != nullptr)
+	         n -> notify ();
+	   }
+	}
+}
+//
+//	the ratio is with respect to cs16, i.e. 4 bytes per sample,
+//	nothing to tell if nothing was coded
+QString	sampleCompressor::statistics	() {
+uint64_t in	= bytesIn. load ();
+uint64_t out	= bytesOut. load ();
+float	average	= out > 0 ? (float)in / out : 0;
+	if (nrBlocks. load () == 0)
+	   return QString ("");
+	return QString ("compression ") +
+	       QString::number (lastRatio. load (), 'f', 2) +
+	       " (avg " + QString::number (average, 'f', 2) + ") " +
+	       QString::number (lastEncodeTime. load ()) + " us/block" +
+	       " dropped " + QString::number ((qulonglong)nrDropped. load ());
+}
+
@@ -0,0 +1,73 @@
+#
+/*
+ *    Copyright (C)  2025
+ *    Jan van Katwijk (J.vanKatwijk@gmail.com)
+ *    Lazy Chair Computing
+ *
+ *    This file is part of the sdrplayServer
+ *
+ *    sdrplayServerr is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    sdrplayServer is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with sdrplayServerr; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#pragma once
+
+#include	<QThread>
+#include	<QString>
+#include	<atomic>
+#include	<complex>
+#include	<vector>
+#include	"ringbuffer.h"
+#include	"sample-notifier.h"
+
+//
+//	The compressor codes the samples for the clients that asked
+//	for the compressed format. It runs in its own thread, the
+//	streamer passes the samples (newData) and picks up the
+//	frames (nextFrame), both without blocking.
+//	The frames are coded as described in rice-coder.h
+class	sampleCompressor: public QThread {
+Q_OBJECT
+public:
+		sampleCompressor	(int blockSize, int loss);
+		~sampleCompressor	();
+	void	newData		(const std::complex<int16_t> *, int);
+	bool	nextFrame	(std::vector<uint8_t> &);
+	void	setBitDepth	(int);
+	void	setNotifier	(sampleNotifier *);
+	void	stop		();
+	QString	statistics	();
+private:
+	void	run		();
+	RingBuffer<std::complex<int16_t>>	inBuffer;
+	RingBuffer<uint8_t>	outBuffer;
+	sampleNotifier	dataNotifier;
+	std::atomic<sampleNotifier *>	frameNotifier;
+	std::atomic<bool>	running;
+	std::atomic<int>	nrBits;
+	int		blockSize;
+	int		loss;
+//	sized for blockSize in the constructor
+	std::vector<std::complex<int16_t>>	block;
+	std::vector<uint32_t>	work;
+	std::vector<uint8_t>	frame;
+//	statistics, per block, written by the compressor's thread
+	std::atomic<float>	lastRatio;
+	std::atomic<int>	lastEncodeTime;
+	std::atomic<uint64_t>	nrBlocks;
+	std::atomic<uint64_t>	bytesIn;
+	std::atomic<uint64_t>	bytesOut;
+	std::atomic<uint64_t>	nrDropped;
+};
+
@@ -0,0 +1,108 @@
+#
+/*
+ *    Copyright (C)  2025
+ *    Jan van Katwijk (J.vanKatwijk@gmail.com)
+ *    Lazy Chair Computing
+ *
+ *    This file is part of the sdrplayServer
+ *
+ *    sdrplayServerr is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    sdrplayServer is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with sdrplayServerr; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include	"sampleStreamer.h"
+#include	"tcpHandler.h"
+#include	"udpHandler.h"
+#ifdef	HAVE_SHM
+#include	"shmHandler.h"
+#endif
+
+
+//	the samples are copied from the buffer in blocks of at most
+//	STREAM_BLOCK samples, they are only passed on when they were
+//	not overwritten during the copy
+#define	STREAM_BLOCK	32768
+
+	sampleStreamer::sampleStreamer	(broadcastRing<std::complex<int16_t>> *b,
+	                                 TcpHandler	*theHandler,
+	                                 UdpHandler	*udpHandler,
+	                                 ShmHandler	*shmHandler):
+	                                    block (STREAM_BLOCK) {
+	this	-> _I_Buffer	= b;
+	this	-> theHandler	= theHandler;
+	this	-> udpHandler	= udpHandler;
+	this	-> shmHandler	= shmHandler;
+	reader	= _I_Buffer -> addReader ("network");
+	lost	= 0;
+//	set before the thread starts, a stop () before it is scheduled
+//	is then not overwritten
+	running. store (true);
+	start ();
+}
+
+	sampleStreamer::~sampleStreamer	() {
+	stop ();
+	_I_Buffer	-> removeReader (reader);
+}
+
+sampleNotifier	*sampleStreamer::notifier	() {
+	return &dataNotifier;
+}
+
+void	sampleStreamer::stop	() {
+	running. store (false);
+	while (isRunning ())
+	   usleep (1000);
+}
+
+void	sampleStreamer::run	() {
+int	amount;
+bool	sent;
+bool	overrun;
+	while (running. load ()) {
+//	we wake up at least once per latency cap to send data
+//	held back for coalescing
+	   dataNotifier. wait (theHandler -> latency ());
+	   sent	= false;
+	   while (running. load ()) {
+//	we take an even number of samples, the packed format needs that
+	      amount	= std::min ((int)(_I_Buffer ->
+	                                GetRingBufferReadAvailable (reader)),
+	                            STREAM_BLOCK) & ~01;
+	      amount	= _I_Buffer -> getDataFromBuffer (reader,
+	                                              block. data (), amount);
+	      overrun	= _I_Buffer -> overrun (reader);
+	      if (overrun) {
+	         uint64_t nowLost = reader -> lost. load ();
+	         theHandler	-> samplesLost (nowLost - lost);
+	         lost	= nowLost;
+	      }
+	      if (amount == 0) {
+	         if (overrun)	// try again from the new position
+	            continue;
+	         break;
+	      }
+	      sent	= true;
+	      theHandler	-> newData (block. data (), amount);
+	      if (udpHandler != nullptr)
+	         udpHandler -> newData (block. data (), amount);
+#ifdef	HAVE_SHM
+	      if (shmHandler != nullptr)
+	         shmHandler -> newData (block. data (), amount);
+#endif
+	   }
+	   if (!sent)
+	      theHandler -> flush ();
+	}
+}
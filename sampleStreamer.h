@@ -0,0 +1,67 @@
+#
+/*
+ *    Copyright (C)  2025
+ *    Jan van Katwijk (J.vanKatwijk@gmail.com)
+ *    Lazy Chair Computing
+ *
+ *    This file is part of the sdrplayServer
+ *
+ *    sdrplayServerr is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    sdrplayServer is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with sdrplayServerr; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#pragma once
+
+#include	<QThread>
+#include	<atomic>
+#include	<complex>
+#include	<vector>
+#include	"broadcast-ring.h"
+#include	"sample-notifier.h"
+
+class	TcpHandler;
+class	UdpHandler;
+class	ShmHandler;
+//
+//	The sampleStreamer is the reader of the sample buffer for the
+//	network side (the spectrum has a reader of its own).
+//	It runs in its own thread, is woken up by the device when
+//	enough samples are available and passes the samples on
+//	to the clients, and to the udp and shared memory readers,
+//	if any. The clients share the conversions, so they share the
+//	reader; each client has its own bounded buffer behind it.
+//	When the streamer falls too far behind, the samples lost are
+//	reported to the clients as dropped.
+class	sampleStreamer: public QThread {
+Q_OBJECT
+public:
+		sampleStreamer	(broadcastRing<std::complex<int16_t>> *,
+	                         TcpHandler *, UdpHandler *,
+	                         ShmHandler *);
+		~sampleStreamer	();
+	sampleNotifier	*notifier	();
+	void		stop		();
+private:
+	void		run		();
+	broadcastRing<std::complex<int16_t>> *_I_Buffer;
+	ringCursor	*reader;
+	TcpHandler	*theHandler;
+	UdpHandler	*udpHandler;
+	ShmHandler	*shmHandler;
+	sampleNotifier	dataNotifier;
+	std::atomic<bool>	running;
+	std::vector<std::complex<int16_t>> block;
+	uint64_t	lost;
+};
+
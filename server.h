@@ -30,8 +30,10 @@
 #include	<QTimer>
 #include	<atomic>
 #include	<complex>
+#include	<vector>
+#include	<utility>
 #include	"ui_server.h"
-#include	"ringbuffer.h"
+#include	"broadcast-ring.h"
 #include	"device-handler.h"
 #include	"errorlog.h"
 #include        "settings-handler.h"
@@ -41,6 +43,9 @@
 
 class	QSettings;
 class	TcpHandler;
+class	UdpHandler;
+class	ShmHandler;
+class	sampleStreamer;
 /*
  *	The main gui object. It inherits from
  *	QDialog and the generated form
@@ -56,14 +61,32 @@ private:
 	QSettings	*serverSettings;
 	common_fft	fftHandler;
 	TcpHandler	*handler_1234;
-	RingBuffer<std::complex<uint8_t>> _I_Buffer;
+	UdpHandler	*udpHandler;
+	ShmHandler	*shmHandler;
+	broadcastRing<std::complex<int16_t>> _I_Buffer;
+	ringCursor	*spectrumReader;
 	deviceHandler	*theDevice;
 	int		portNumber;
 	spectrumScope	*theScope;
+	sampleStreamer	*theStreamer;
+	QTimer		displayTimer;
+	QTimer		statisticsTimer;
+	QTimer		commandTimer;
+	int		commandWindow;
+	int		nrCoalesced;
+	std::vector<std::pair<uint8_t, uint32_t>> pendingCommands;
+	void		queueCommand		(uint8_t, uint32_t);
+	void		applyCommand		(uint8_t, uint32_t);
 public slots:
 	void		dispatch		(QByteArray &);
-	void		newData			(int);
+	void		applyCommands		();
+	void		showSpectrum		();
+	void		showStatistics		();
+	void		handle_policySelector	(int);
 	void		handle_portSelector	(int);
 	void		setStatus		(const QString &);
+	void		handle_rateChanged	(int);
+signals:
+	void		rateChanged		(int);
 };
 
@@ -34,13 +34,26 @@ INCLUDEPATH += . \
 # Input
 HEADERS += ./server.h \
 	   ./tcpHandler.h \
+	   ./tcpClient.h \
+	   ./udpHandler.h \
+	   ./sampleStreamer.h \
+	   ./sampleCompressor.h \
 	   ./support/ringbuffer.h \
+	   ./support/mirrored-buffer.h \
+	   ./support/broadcast-ring.h \
+	   ./support/bounded-queue.h \
+	   ./support/sample-notifier.h \
+	   ./support/sample-formats.h \
+	   ./support/simd-kernels.h \
+	   ./support/rice-coder.h \
+	   ./support/ddc-channel.h \
+	   ./support/fb-channelizer.h \
 	   ./support/settings-handler.h \
 	   ./support/errorlog.h \
 	   ./support/spectrum-scope.h \
 	   ./support/fft.h \
 	   ./support/base-converter.h \
-	   ./support/interpolator.h \
+	   ./support/resampler.h \
 	   ./devices/device-exceptions.h \
 	   ./devices/device-handler.h \
 	   ./devices/sdrplay-handler-v3/sdrplay-handler-v3.h \
@@ -60,12 +73,23 @@ FORMS	+= ./server.ui \
 SOURCES += ./main.cpp \
            ./server.cpp \
 	   ./tcpHandler.cpp \
+	   ./tcpClient.cpp \
+	   ./udpHandler.cpp \
+	   ./sampleStreamer.cpp \
+	   ./sampleCompressor.cpp \
 	   ./support/settings-handler.cpp \
+	   ./support/sample-notifier.cpp \
+	   ./support/mirrored-buffer.cpp \
+	   ./support/sample-formats.cpp \
+	   ./support/simd-kernels.cpp \
+	   ./support/rice-coder.cpp \
+	   ./support/ddc-channel.cpp \
+	   ./support/fb-channelizer.cpp \
 	   ./support/errorlog.cpp \
 	   ./support/spectrum-scope.cpp \
 	   ./support/fft.cpp \
 	   ./support/base-converter.cpp \
-	   ./support/interpolator.cpp \
+	   ./support/resampler.cpp \
 	   ./devices/device-handler.cpp \
 	   ./devices/sdrplay-handler-v3/sdrplay-handler-v3.cpp \
 	   ./devices/sdrplay-handler-v3/Rsp-device.cpp \
@@ -86,6 +110,14 @@ PKGCONFIG       += libusb-1.0
 !mac {
 LIBS            += -ldl
 }
+#	the shared memory output uses futexes, i.e. linux only
+linux {
+DEFINES		+= HAVE_SHM
+HEADERS		+= ./shmHandler.h \
+	           ./support/shm-layout.h
+SOURCES		+= ./shmHandler.cpp
+LIBS		+= -lrt
+}
 
 INCLUDEPATH     += /usr/include/qt6/
 INCLUDEPATH     += /usr/include/qt6/qwt
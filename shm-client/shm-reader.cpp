@@ -0,0 +1,156 @@
+#
+/*
+ *    Copyright (C)  2025
+ *    Jan van Katwijk (J.vanKatwijk@gmail.com)
+ *    Lazy Chair Computing
+ *
+ *    This file is part of the sdrplayServer
+ *
+ *    sdrplayServerr is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    sdrplayServer is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with sdrplayServerr; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include	"shm-reader.h"
+#include	<sys/mman.h>
+#include	<sys/stat.h>
+#include	<sys/syscall.h>
+#include	<linux/futex.h>
+#include	<fcntl.h>
+#include	<unistd.h>
+#include	<string.h>
+#include	<time.h>
+#include	<errno.h>
+#include	<stdexcept>
+
+//
+//	the samples are mapped read only, the reader only has its
+//	own cursor. The header is writable, for the waiters count
+	shmReader::shmReader	(const char *name) {
+struct stat st;
+	fd	= shm_open (name, O_RDWR, 0);
+	if (fd < 0)
+	   throw std::runtime_error ("shm segment not found");
+	if ((fstat (fd, &st) < 0) || (st. st_size < SHM_HEADER_SIZE)) {
+	   close (fd);
+	   throw std::runtime_error ("shm segment is not valid");
+	}
+	segmentSize	= st. st_size;
+	void *base	= mmap (nullptr, segmentSize, PROT_READ,
+	                                       MAP_SHARED, fd, 0);
+	if (base == MAP_FAILED) {
+	   close (fd);
+	   throw std::runtime_error ("cannot map the shm segment");
+	}
+	if (mprotect (base, SHM_HEADER_SIZE, PROT_READ | PROT_WRITE) < 0) {
+	   munmap (base, segmentSize);
+	   close (fd);
+	   throw std::runtime_error ("cannot map the shm header");
+	}
+	header	= (shmHeader *)base;
+//	the geometry is read (and checked) once, read () only uses our
+//	own copy, whatever is written in the header later on
+	capacity	= header -> capacity;
+	uint32_t maxChunk	= header -> maxChunk;
+	uint32_t headerSize	= header -> headerSize;
+	if ((memcmp (header -> magic, SHM_MAGIC, 8) != 0) ||
+	    (header -> version != SHM_VERSION) ||
+	    (capacity == 0) || ((capacity & (capacity - 1)) != 0) ||
+	    (maxChunk >= capacity) ||
+	    (headerSize < sizeof (shmHeader)) ||
+	    ((uint64_t)segmentSize < (uint64_t)headerSize +
+	          (uint64_t)capacity * sizeof (std::complex<int16_t>))) {
+	   munmap (base, segmentSize);
+	   close (fd);
+	   throw std::runtime_error ("shm segment is not valid");
+	}
+	mask	= capacity - 1;
+	samples	= (const std::complex<int16_t> *)
+	                        ((const uint8_t *)base + headerSize);
+	window	= capacity - maxChunk;
+	cursor	= header -> writeSeq. load (std::memory_order_acquire);
+	nrLost	= 0;
+}
+
+	shmReader::~shmReader	() {
+	munmap (header, segmentSize);
+	close (fd);
+}
+
+int	shmReader::sampleRate	() {
+	return header -> sampleRate. load ();
+}
+
+int	shmReader::nrBits	() {
+	return header -> nrBits. load ();
+}
+
+uint64_t shmReader::lost	() {
+	return nrLost;
+}
+
+//
+//	the writer only wakes us when it sees waiters is not zero
+//	(see shm-layout.h)
+void	shmReader::wait	(uint32_t word, int timeout_ms) {
+struct timespec ts;
+	ts. tv_sec	= timeout_ms / 1000;
+	ts. tv_nsec	= (timeout_ms % 1000) * 1000000L;
+	header	-> waiters. fetch_add (1, std::memory_order_seq_cst);
+	syscall (SYS_futex, &header -> futexWord, FUTEX_WAIT,
+	                                     word, &ts, nullptr, 0);
+	header	-> waiters. fetch_sub (1, std::memory_order_seq_cst);
+}
+//
+//	returns the number of samples read, SHM_TIMEOUT (0) on a timeout,
+//	SHM_STOPPED if the server stopped. Since the server does not
+//	wait for us, the data is checked after copying: if the writer
+//	came too close, the copy may be overwritten, it is discarded
+//	and SHM_OVERRUN is returned
+int	shmReader::read	(std::complex<int16_t> *out,
+	                         int maxSamples, int timeout_ms) {
+uint32_t word	= header -> futexWord. load (std::memory_order_acquire);
+uint64_t seq	= header -> writeSeq. load (std::memory_order_acquire);
+	if (memcmp (header -> magic, SHM_MAGIC, 8) != 0)
+	   return SHM_STOPPED;
+	if (seq == cursor) {
+	   wait (word, timeout_ms);
+	   seq	= header -> writeSeq. load (std::memory_order_acquire);
+	   if (seq == cursor)
+	      return memcmp (header -> magic, SHM_MAGIC, 8) == 0 ?
+	                                   SHM_TIMEOUT : SHM_STOPPED;
+	}
+	if (seq - cursor > window) {		// we were too slow
+	   nrLost	+= seq - window - cursor;
+	   cursor	= seq - window;
+	}
+	int amount	= seq - cursor < (uint64_t)maxSamples ?
+	                                 seq - cursor : maxSamples;
+	uint32_t slot	= cursor & mask;
+	int first	= amount < (int)(capacity - slot) ?
+	                                 amount : capacity - slot;
+	memcpy (out, &samples [slot], first * sizeof (std::complex<int16_t>));
+	if (amount > first)
+	   memcpy (&out [first], &samples [0],
+	                    (amount - first) * sizeof (std::complex<int16_t>));
+	std::atomic_thread_fence (std::memory_order_acquire);
+	seq	= header -> writeSeq. load (std::memory_order_acquire);
+	if (seq - cursor > window) {		// overwritten while copying
+	   nrLost	+= amount;
+	   cursor	+= amount;
+	   return SHM_OVERRUN;
+	}
+	cursor	+= amount;
+	return amount;
+}
+
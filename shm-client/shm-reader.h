@@ -0,0 +1,76 @@
+#
+/*
+ *    Copyright (C)  2025
+ *    Jan van Katwijk (J.vanKatwijk@gmail.com)
+ *    Lazy Chair Computing
+ *
+ *    This file is part of the sdrplayServer
+ *
+ *    sdrplayServerr is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    sdrplayServer is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with sdrplayServerr; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#pragma once
+
+#include	<stdint.h>
+#include	<stddef.h>
+#include	<complex>
+#include	"../support/shm-layout.h"
+
+//
+//	A reader for the samples the sdrplayServer publishes in
+//	shared memory. It does not need Qt, just add shm-reader.cpp
+//	and link with -lrt (older glibc's).
+//
+//	shmReader reader ("/sdrplay_tcp");
+//	std::complex<int16_t> buffer [8192];
+//	while (true) {
+//	   int n = reader. read (buffer, 8192, 100);
+//	   if (n == SHM_STOPPED)	// the server went away
+//	      break;
+//	   if (n == SHM_OVERRUN)	// the copy was overwritten
+//	      continue;
+//	   ... n samples, reader. nrBits () bits, reader. sampleRate ()
+//	}
+//
+//	A reader starts at the most recent sample. If it does not keep
+//	up, samples are skipped, lost () tells how many.
+//	The reader needs write access to the segment, it registers
+//	itself in the header while it waits.
+#define	SHM_TIMEOUT	0
+#define	SHM_STOPPED	(-1)
+#define	SHM_OVERRUN	(-2)
+
+class	shmReader {
+public:
+		shmReader	(const char *name);
+		~shmReader	();
+	int	read		(std::complex<int16_t> *, int maxSamples,
+	                                                    int timeout_ms);
+	int	sampleRate	();
+	int	nrBits		();
+	uint64_t	lost	();
+private:
+	int		fd;
+	size_t		segmentSize;
+	shmHeader	*header;
+	const std::complex<int16_t>	*samples;
+	uint64_t	cursor;
+	uint64_t	nrLost;
+	uint32_t	capacity;
+	uint32_t	mask;
+	uint32_t	window;
+	void		wait		(uint32_t word, int timeout_ms);
+};
+
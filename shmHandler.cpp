@@ -0,0 +1,158 @@
+#
+/*
+ *    Copyright (C)  2025
+ *    Jan van Katwijk (J.vanKatwijk@gmail.com)
+ *    Lazy Chair Computing
+ *
+ *    This file is part of the sdrplayServer
+ *
+ *    sdrplayServerr is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    sdrplayServer is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with sdrplayServerr; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include	"shmHandler.h"
+#include	"settings-handler.h"
+#include	<sys/mman.h>
+#include	<sys/stat.h>
+#include	<sys/syscall.h>
+#include	<linux/futex.h>
+#include	<fcntl.h>
+#include	<unistd.h>
+#include	<limits.h>
+#include	<string.h>
+#include	<stdio.h>
+#include	<errno.h>
+#include	<stdlib.h>
+#include	<grp.h>
+#include	<new>
+
+#define	SHM_SETTINGS	"SHM_SETTINGS"
+/*
+ *	shmName is the name of the segment, shmSize the number of
+ *	samples it holds (rounded up to a power of 2), the default,
+ *	2^20 samples, is half a second at 2 MS/s.
+ *	Readers need write access (they register in the header while
+ *	waiting), so only users that may read should have it: shmMode
+ *	is the (octal) mode of the segment, default 0660, shmGroup the
+ *	group it is given ("" keeps ours)
+ */
+	ShmHandler::ShmHandler	(QSettings *s) {
+int	size	= value_i (s, SHM_SETTINGS, "shmSize", 1 << 20);
+QString	mode	= value_s (s, SHM_SETTINGS, "shmMode", "0660");
+QString	group	= value_s (s, SHM_SETTINGS, "shmGroup", "");
+mode_t	access	= strtol (mode. toLatin1 (). data (), nullptr, 8) & 0666;
+	name	= value_s (s, SHM_SETTINGS, "shmName", "/sdrplay_tcp");
+	capacity	= 4096;
+	while ((int)capacity < size)
+	   capacity <<= 1;
+	maxChunk	= capacity / 4;
+	segmentSize	= SHM_HEADER_SIZE +
+	                       capacity * sizeof (std::complex<int16_t>);
+	shm_unlink (name. toLatin1 (). data ());	// a left over
+	fd	= shm_open (name. toLatin1 (). data (),
+	                         O_CREAT | O_EXCL | O_RDWR, 0600);
+	if (fd < 0) {
+	   fprintf (stderr, "shm: cannot create %s (%s)\n",
+	                  name. toLatin1 (). data (), strerror (errno));
+	   throw (31);
+	}
+	if (group != "") {
+	   struct group *g	= getgrnam (group. toLatin1 (). data ());
+	   if ((g == nullptr) || (fchown (fd, -1, g -> gr_gid) < 0))
+	      fprintf (stderr, "shm: cannot give %s to group %s\n",
+	                  name. toLatin1 (). data (), group. toLatin1 (). data ());
+	}
+	fchmod (fd, access);		// not restricted by the umask
+	if (ftruncate (fd, segmentSize) < 0) {
+	   close (fd);
+	   shm_unlink (name. toLatin1 (). data ());
+	   throw (32);
+	}
+	void *base	= mmap (nullptr, segmentSize,
+	                        PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (base == MAP_FAILED) {
+	   close (fd);
+	   shm_unlink (name. toLatin1 (). data ());
+	   throw (33);
+	}
+	header	= new (base) shmHeader;
+	samples	= (std::complex<int16_t> *)((uint8_t *)base + SHM_HEADER_SIZE);
+	header	-> version	= SHM_VERSION;
+	header	-> headerSize	= SHM_HEADER_SIZE;
+	header	-> capacity	= capacity;
+	header	-> maxChunk	= maxChunk;
+	header	-> nrBits. store (12);
+	header	-> sampleRate. store (2048000);
+	header	-> writeSeq. store (0);
+	header	-> futexWord. store (0);
+	header	-> waiters. store (0);
+//	the magic is written last, a reader checks it
+	std::atomic_thread_fence (std::memory_order_release);
+	memcpy (header -> magic, SHM_MAGIC, 8);
+}
+
+	ShmHandler::~ShmHandler	() {
+	memset (header -> magic, 0, 8);		// tell the readers
+	wakeReaders ();
+	munmap (header, segmentSize);
+	close (fd);
+	shm_unlink (name. toLatin1 (). data ());
+}
+
+void	ShmHandler::setSampleRate	(int rate) {
+	header	-> sampleRate. store (rate);
+}
+
+void	ShmHandler::setBitDepth	(int nrBits) {
+	header	-> nrBits. store (nrBits);
+}
+
+QString	ShmHandler::statistics	() {
+	return QString ("shm ") +
+	       QString::number ((qulonglong)(header -> writeSeq. load ())) +
+	       " samples";
+}
+
+//
+//	The increment and the load of waiters are sequentially consistent,
+//	as are the increment of waiters and the load of futexWord by a
+//	reader: either we see the reader, or its FUTEX_WAIT sees the new
+//	futexWord and does not sleep. Without readers there is no syscall
+void	ShmHandler::wakeReaders	() {
+	header	-> futexWord. fetch_add (1, std::memory_order_seq_cst);
+	if (header -> waiters. load (std::memory_order_seq_cst) != 0)
+	   syscall (SYS_futex, &header -> futexWord, FUTEX_WAKE,
+	                                   INT_MAX, nullptr, nullptr, 0);
+}
+//
+//	we write at most maxChunk samples before telling how far we are
+void	ShmHandler::newData	(const std::complex<int16_t> *v, int size) {
+uint64_t seq	= header -> writeSeq. load (std::memory_order_relaxed);
+	while (size > 0) {
+	   int amount	= size < (int)maxChunk ? size : maxChunk;
+	   uint32_t slot	= seq & (capacity - 1);
+	   int first	= amount < (int)(capacity - slot) ?
+	                                  amount : capacity - slot;
+	   memcpy (&samples [slot], v, first * sizeof (std::complex<int16_t>));
+	   if (amount > first)
+	      memcpy (&samples [0], &v [first],
+	                  (amount - first) * sizeof (std::complex<int16_t>));
+	   seq	+= amount;
+	   header -> writeSeq. store (seq, std::memory_order_release);
+	   v	+= amount;
+	   size	-= amount;
+	}
+	wakeReaders ();
+}
+
@@ -0,0 +1,59 @@
+#
+/*
+ *    Copyright (C)  2025
+ *    Jan van Katwijk (J.vanKatwijk@gmail.com)
+ *    Lazy Chair Computing
+ *
+ *    This file is part of the sdrplayServer
+ *
+ *    sdrplayServerr is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    sdrplayServer is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with sdrplayServerr; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#pragma once
+
+#include	<complex>
+#include	<stdint.h>
+#include	<QString>
+#include	"shm-layout.h"
+
+class	QSettings;
+//
+//	The ShmHandler publishes the samples in a POSIX shared memory
+//	segment, such that readers on the same host get the samples
+//	without a copy through the network stack. The readers map the
+//	segment read only, each reader keeps its own position, a
+//	reader that is too slow just misses samples, the server never
+//	waits. Readers are woken up through a futex in the segment.
+//	See shm-layout.h for the layout, shm-client for a reader.
+//	newData is called from the streamer's thread.
+class	ShmHandler {
+public:
+		ShmHandler	(QSettings *);
+		~ShmHandler	();
+	void	newData		(const std::complex<int16_t> *, int);
+	void	setSampleRate	(int);
+	void	setBitDepth	(int);
+	QString	statistics	();
+private:
+	QString		name;
+	int		fd;
+	size_t		segmentSize;
+	shmHeader	*header;
+	std::complex<int16_t>	*samples;
+	uint32_t	capacity;
+	uint32_t	maxChunk;
+	void		wakeReaders	();
+};
+
@@ -1,13 +1,17 @@
-
-
-
 #include	"base-converter.h"
+#include	<algorithm>
 
 	baseConverter::baseConverter	() {}
 	baseConverter::~baseConverter	() {}
-bool	baseConverter::process		(std::complex<int16_t> inVal,
-	                                      std::complex<int16_t> & outVal) {
-	outVal = inVal;
-	return true;
+int	baseConverter::process		(const std::complex<int16_t> *in,
+	                                 int n,
+	                                 std::complex<int16_t> *out,
+	                                 int maxOut, int &nOut) {
+	nOut	= std::min (n, maxOut);
+	std::copy (in, in + nOut, out);
+	return nOut;
 }
 
+bool	baseConverter::changesRate	() {
+	return false;
+}
@@ -1,15 +1,20 @@
-
-
 #pragma once
 
 #include	<stdint.h>
 #include	<complex>
-
+//
+//	A converter works on blocks: it takes at most n input samples
+//	and writes at most maxOut output samples, nOut tells how many
+//	were written, the return value how many input samples were used.
+//	Input that is not used (when the output is full) should be
+//	offered again. The base converter just copies.
 class	baseConverter {
 public:
 		baseConverter	();
-		~baseConverter	();
-virtual	bool	process		(std::complex<int16_t>,
-	                                   std::complex<int16_t> &);
+virtual		~baseConverter	();
+virtual	int	process		(const std::complex<int16_t> *in, int n,
+	                         std::complex<int16_t> *out, int maxOut,
+	                                                 int &nOut);
+virtual	bool	changesRate	();
 };
 
@@ -0,0 +1,114 @@
+#
+/*
+ *    Copyright (C) 2025
+ *    Jan van Katwijk (J.vanKatwijk@gmail.com)
+ *    Lazy Chair Computing
+ *
+ *    This file is part of sdrplay_tcp
+ *
+ *    sdrplay_tcp is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    sdrplay_tcp is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with sdrplay_tcp; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#pragma once
+
+#include	<atomic>
+#include	<stddef.h>
+#include	<stdint.h>
+//
+//	A bounded, lock free, queue for many writers and readers,
+//	after Dmitry Vyukov's bounded MPMC queue.
+//	Each cell has a sequence number, telling whether the cell is
+//	free for the writer with that position, or filled for the
+//	reader with that position. A writer claims a position with a
+//	compare and swap on the write position, and then publishes the
+//	cell by storing the next sequence number. No locks, and no
+//	allocation after construction.
+//	The size is rounded up to a power of two, push and pop return
+//	false when the queue is full resp. empty.
+template <class elementtype>
+class	boundedQueue {
+private:
+	struct cell {
+	   std::atomic<size_t>	sequence;
+	   elementtype		data;
+	};
+	cell		*buffer;
+	size_t		mask;
+alignas (64)	std::atomic<size_t>	writePos;
+alignas (64)	std::atomic<size_t>	readPos;
+public:
+	boundedQueue	(size_t size) {
+	size_t n	= 2;
+	   while (n < size)
+	      n <<= 1;
+	   buffer	= new cell [n];
+	   mask		= n - 1;
+	   for (size_t i = 0; i < n; i ++)
+	      buffer [i]. sequence. store (i, std::memory_order_relaxed);
+	   writePos. store (0, std::memory_order_relaxed);
+	   readPos. store (0, std::memory_order_relaxed);
+	}
+
+	~boundedQueue	() {
+	   delete [] buffer;
+	}
+
+	bool	push	(const elementtype &v) {
+	cell	*c;
+	size_t	pos	= writePos. load (std::memory_order_relaxed);
+	   for (;;) {
+	      c	= &buffer [pos & mask];
+	      size_t seq = c -> sequence. load (std::memory_order_acquire);
+	      intptr_t dif = (intptr_t)seq - (intptr_t)pos;
+	      if (dif == 0) {
+	         if (writePos. compare_exchange_weak (pos, pos + 1,
+	                                     std::memory_order_relaxed))
+	            break;
+	      }
+	      else
+	      if (dif < 0)		// full
+	         return false;
+	      else
+	         pos	= writePos. load (std::memory_order_relaxed);
+	   }
+	   c -> data	= v;
+	   c -> sequence. store (pos + 1, std::memory_order_release);
+	   return true;
+	}
+
+	bool	pop	(elementtype &v) {
+	cell	*c;
+	size_t	pos	= readPos. load (std::memory_order_relaxed);
+	   for (;;) {
+	      c	= &buffer [pos & mask];
+	      size_t seq = c -> sequence. load (std::memory_order_acquire);
+	      intptr_t dif = (intptr_t)seq - (intptr_t)(pos + 1);
+	      if (dif == 0) {
+	         if (readPos. compare_exchange_weak (pos, pos + 1,
+	                                     std::memory_order_relaxed))
+	            break;
+	      }
+	      else
+	      if (dif < 0)		// empty
+	         return false;
+	      else
+	         pos	= readPos. load (std::memory_order_relaxed);
+	   }
+	   v	= c -> data;
+	   c -> sequence. store (pos + mask + 1, std::memory_order_release);
+	   return true;
+	}
+};
+
@@ -0,0 +1,315 @@
+#
+/*
+ *    Copyright (C) 2025
+ *    Jan van Katwijk (J.vanKatwijk@gmail.com)
+ *    Lazy Chair Computing
+ *
+ *    This file is part of sdrplay_tcp
+ *
+ *    sdrplay_tcp is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    sdrplay_tcp is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with sdrplay_tcp; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#pragma once
+
+#include	<stdint.h>
+#include	<stdio.h>
+#include	<string.h>
+#include	<atomic>
+#include	<mutex>
+#include	<string>
+#include	<vector>
+#include	<algorithm>
+#include	"mirrored-buffer.h"
+//
+//	A ring for a single writer and any number of readers, each
+//	reader has its own cursor. The writer never waits: it overwrites
+//	the oldest data, whether read or not. A reader that falls more
+//	than the size of the ring behind is overrun, it then skips to
+//	half a ring behind the writer, the overrun is counted and
+//	flagged, so the reader can tell its own consumers.
+//
+//	The positions are free running 64 bit counters. Before writing,
+//	the writer "claims" the elements it is going to write, a reader
+//	that copied (or otherwise used) elements checks afterwards that
+//	none of them was claimed in the mean time, as in a seqlock. So
+//	a reader never passes on data that was overwritten while it
+//	was reading.
+//	Where possible (Linux) the storage is mirrored, the regions
+//	then never wrap.
+#define	RING_CACHE_LINE	64
+
+class	alignas (RING_CACHE_LINE) ringCursor {
+public:
+	std::string		name;
+	std::atomic<uint64_t>	position;	// the next element to read
+	std::atomic<uint64_t>	overruns;	// times the reader was overrun
+	std::atomic<uint64_t>	lost;		// elements skipped for that
+	std::atomic<bool>	overrun;	// set on overrun, see below
+		ringCursor	(const std::string &name, uint64_t start):
+	                                                   name (name) {
+	   position. store (start);
+	   overruns. store (0);
+	   lost. store (0);
+	   overrun. store (false);
+	}
+};
+
+template <class elementtype>
+class	broadcastRing {
+private:
+	uint32_t	bufferSize;
+	uint32_t	smallMask;
+	char		*buffer;
+	mirroredBuffer	*storage;
+	bool		mirrored;
+alignas (RING_CACHE_LINE)
+	std::atomic<uint64_t>	writeIndex;	// written up to here
+	std::atomic<uint64_t>	claimIndex;	// being written up to here
+alignas (RING_CACHE_LINE)
+	std::atomic<uint64_t>	flushIndex;	// readers skip up to here
+	std::mutex		readerLocker;
+	std::vector<ringCursor *>	readers;
+
+	void	regions		(uint64_t start, uint32_t amount,
+	                         void **dataPtr1, int32_t *sizePtr1,
+	                         void **dataPtr2, int32_t *sizePtr2) {
+	uint32_t index	= start & smallMask;
+	   *dataPtr1	= &buffer [index * sizeof (elementtype)];
+	   if (!mirrored && (index + amount > bufferSize)) {
+	      *sizePtr1	= bufferSize - index;
+	      *dataPtr2	= &buffer [0];
+	      *sizePtr2	= amount - *sizePtr1;
+	   }
+	   else {
+	      *sizePtr1	= amount;
+	      *dataPtr2	= nullptr;
+	      *sizePtr2	= 0;
+	   }
+	}
+//
+//	true if none of the elements from "start" on was (or is being)
+//	overwritten
+	bool	stillValid	(uint64_t start) {
+	   std::atomic_thread_fence (std::memory_order_acquire);
+	   return claimIndex. load (std::memory_order_relaxed) - start <=
+	                                                        bufferSize;
+	}
+
+	void	markOverrun	(ringCursor *r, uint64_t skipped) {
+	   r -> overruns. fetch_add (1);
+	   r -> lost. fetch_add (skipped);
+	   r -> overrun. store (true, std::memory_order_release);
+	}
+//
+//	the reader's position, after a flush or an overrun
+	uint64_t	startOf		(ringCursor *r) {
+	uint64_t pos	= r -> position. load (std::memory_order_relaxed);
+	uint64_t w	= writeIndex. load (std::memory_order_acquire);
+	uint64_t f	= flushIndex. load (std::memory_order_acquire);
+	   if (pos < f)
+	      pos	= f;
+	   if (w - pos > bufferSize) {
+	      uint64_t newPos	= w - bufferSize / 2;
+	      markOverrun (r, newPos - pos);
+	      pos	= newPos;
+	   }
+	   r -> position. store (pos, std::memory_order_release);
+	   return pos;
+	}
+public:
+	broadcastRing (uint32_t elementCount) {
+	   bufferSize	= 16384;		// minimum size
+	   while (bufferSize < elementCount)
+	      bufferSize <<= 1;
+	   smallMask	= bufferSize - 1;
+	   storage	= new mirroredBuffer (bufferSize * sizeof (elementtype));
+	   buffer	= storage -> data ();
+	   mirrored	= storage -> isMirrored ();
+	   writeIndex. store (0);
+	   claimIndex. store (0);
+	   flushIndex. store (0);
+	}
+
+	~broadcastRing () {
+	   for (auto r : readers)
+	      delete r;
+	   delete storage;
+	}
+
+	uint32_t	size		() {
+	   return bufferSize;
+	}
+
+	bool	isContiguous	() {
+	   return mirrored;
+	}
+//
+//	The writer's side, the same interface as the RingBuffer has.
+//	There is always room: at most the size of the ring
+int32_t	GetRingBufferWriteRegions (uint32_t elementCount,
+	                           void **dataPtr1, int32_t *sizePtr1,
+	                           void **dataPtr2, int32_t *sizePtr2) {
+uint64_t w	= writeIndex. load (std::memory_order_relaxed);
+	if (elementCount > bufferSize)
+	   elementCount = bufferSize;
+	claimIndex. store (w + elementCount, std::memory_order_relaxed);
+	std::atomic_thread_fence (std::memory_order_release);
+	regions (w, elementCount, dataPtr1, sizePtr1, dataPtr2, sizePtr2);
+	return elementCount;
+}
+
+int32_t	AdvanceRingBufferWriteIndex (int32_t elementCount) {
+uint64_t w	= writeIndex. load (std::memory_order_relaxed) + elementCount;
+	writeIndex. store (w, std::memory_order_release);
+	return w & smallMask;
+}
+//
+//	all readers skip what was written so far, may be called from
+//	any thread
+void	FlushRingBuffer	() {
+	flushIndex. store (writeIndex. load (std::memory_order_acquire),
+	                                         std::memory_order_release);
+}
+
+uint64_t	writePosition	() {
+	return writeIndex. load (std::memory_order_acquire);
+}
+//
+//	A reader starts at the current write position. The cursors
+//	are owned by the ring
+ringCursor	*addReader	(const std::string &name) {
+ringCursor *r	= new ringCursor (name, writePosition ());
+	std::lock_guard<std::mutex> lock (readerLocker);
+	readers. push_back (r);
+	return r;
+}
+
+void	removeReader	(ringCursor *r) {
+	std::lock_guard<std::mutex> lock (readerLocker);
+	auto it	= std::find (readers. begin (), readers. end (), r);
+	if (it != readers. end ()) {
+	   readers. erase (it);
+	   delete r;
+	}
+}
+//
+//	The readers' side, each function is for the thread owning
+//	the cursor
+uint32_t	GetRingBufferReadAvailable (ringCursor *r) {
+uint64_t pos	= startOf (r);
+	return std::min ((uint64_t)bufferSize,
+	                 writeIndex. load (std::memory_order_acquire) - pos);
+}
+//
+//	The regions can be used in place, AdvanceRingBufferReadIndex
+//	then tells whether they were valid all the time. If not, the
+//	results should be discarded
+int32_t	GetRingBufferReadRegions (ringCursor *r, uint32_t elementCount,
+	                          void **dataPtr1, int32_t *sizePtr1,
+	                          void **dataPtr2, int32_t *sizePtr2) {
+uint64_t pos	= startOf (r);
+uint64_t available = writeIndex. load (std::memory_order_acquire) - pos;
+	if (available > bufferSize)	// overrun, detected on advancing
+	   available	= bufferSize;
+	if (elementCount > available)
+	   elementCount = available;
+	regions (pos, elementCount, dataPtr1, sizePtr1, dataPtr2, sizePtr2);
+	return elementCount;
+}
+
+bool	AdvanceRingBufferReadIndex (ringCursor *r, int32_t elementCount) {
+uint64_t pos	= r -> position. load (std::memory_order_relaxed);
+	if (!stillValid (pos)) {
+	   uint64_t newPos = writeIndex. load (std::memory_order_acquire) -
+	                                                     bufferSize / 2;
+	   markOverrun (r, newPos - pos);
+	   r -> position. store (newPos, std::memory_order_release);
+	   return false;
+	}
+	r -> position. store (pos + elementCount, std::memory_order_release);
+	return true;
+}
+//
+//	Copies at most elementCount elements, returns the number copied,
+//	0 if the reader was overrun while copying
+int32_t	getDataFromBuffer (ringCursor *r, void *data, int32_t elementCount) {
+void	*data1, *data2;
+int32_t	size1, size2;
+int32_t	amount	= GetRingBufferReadRegions (r, elementCount,
+	                                    &data1, &size1, &data2, &size2);
+	memcpy (data, data1, size1 * sizeof (elementtype));
+	if (size2 > 0)
+	   memcpy ((char *)data + size1 * sizeof (elementtype),
+	           data2, size2 * sizeof (elementtype));
+	return AdvanceRingBufferReadIndex (r, amount) ? amount : 0;
+}
+//
+//	For readers that only want to look now and then (the spectrum):
+//	a copy of the newest elementCount elements, provided that many
+//	were written since the previous call. Returns false otherwise.
+//	Skipping the older data is not an overrun here, only data
+//	overwritten while being copied is
+bool	getLatest	(ringCursor *r, void *data, int32_t elementCount) {
+void	*data1, *data2;
+int32_t	size1, size2;
+uint64_t w	= writeIndex. load (std::memory_order_acquire);
+uint64_t pos	= r -> position. load (std::memory_order_relaxed);
+uint64_t f	= flushIndex. load (std::memory_order_acquire);
+	if (pos < f)
+	   pos	= f;
+	if ((uint32_t)elementCount > bufferSize / 2 ||
+	                          (w - pos < (uint64_t)elementCount))
+	   return false;
+	regions (w - elementCount, elementCount,
+	                       &data1, &size1, &data2, &size2);
+	memcpy (data, data1, size1 * sizeof (elementtype));
+	if (size2 > 0)
+	   memcpy ((char *)data + size1 * sizeof (elementtype),
+	           data2, size2 * sizeof (elementtype));
+	if (!stillValid (w - elementCount)) {
+	   markOverrun (r, elementCount);
+	   return false;
+	}
+	r -> position. store (w, std::memory_order_release);
+	return true;
+}
+//
+//	the explicit overrun notification: true if the reader was
+//	overrun since the previous call
+bool	overrun		(ringCursor *r) {
+	return r -> overrun. exchange (false);
+}
+//
+//	may be called from any thread
+uint64_t	lag		(ringCursor *r) {
+	return writePosition () -
+	              r -> position. load (std::memory_order_acquire);
+}
+
+std::string	statistics	() {
+std::string	res;
+	std::lock_guard<std::mutex> lock (readerLocker);
+	for (auto r : readers) {
+	   char	line [256];
+	   snprintf (line, sizeof (line), "%s lag %llu overruns %llu lost %llu ",
+	             r -> name. c_str (),
+	             (unsigned long long)lag (r),
+	             (unsigned long long)r -> overruns. load (),
+	             (unsigned long long)r -> lost. load ());
+	   res	+= line;
+	}
+	return res;
+}
+};
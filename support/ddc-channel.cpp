@@ -0,0 +1,153 @@
+#
+/*
+ *    Copyright (C) 2025
+ *    Jan van Katwijk (J.vanKatwijk@gmail.com)
+ *    Lazy Chair Computing
+ *
+ *    This file is part of sdrplay_tcp
+ *
+ *    sdrplay_tcp is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    sdrplay_tcp is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with sdrplay_tcp; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include	"ddc-channel.h"
+#include	<math.h>
+
+#define	MAX_STAGE	8
+#define	TAPS_PER_PHASE	10
+#define	RENORM_SAMPLES	1024		// phasor renormalization interval
+
+//
+//	the largest decimation not above "max" that can be done in
+//	stages of at most MAX_STAGE
+static
+bool	smooth	(int d) {
+	for (int f = MAX_STAGE; f >= 2; f --)
+	   while (d % f == 0)
+	      d /= f;
+	return d == 1;
+}
+
+	ddcChannel::ddcChannel	(int inRate, int offset, int outRate) {
+int	d	= outRate > 0 ? inRate / outRate : 1;
+	if (d < 1)
+	   d = 1;
+	while (!smooth (d))
+	   d --;
+	this	-> inRate	= inRate;
+	this	-> theOffset	= offset;
+	this	-> decimation	= d;
+	granularity	= 1;
+	renormCount	= 0;
+	phasor		= std::complex<float> (1, 0);
+	rotator		= std::complex<float> (
+	                          cos (-2 * M_PI * offset / inRate),
+	                          sin (-2 * M_PI * offset / inRate));
+//	largest factors first, the first stage runs at the input rate
+	for (int f = MAX_STAGE; f >= 2; f --) {
+	   while (d % f == 0) {
+	      decimator s;
+	      s. factor	= f;
+	      s. length	= TAPS_PER_PHASE * f + 1;
+	      s. taps. resize (s. length);
+	      s. history. resize (2 * s. length);
+	      s. index	= 0;
+	      s. phase	= 0;
+	      float	cutoff	= 0.45 / f;
+	      float	sum	= 0;
+	      for (int i = 0; i < s. length; i ++) {
+	         int	n	= i - s. length / 2;
+	         float	sinc	= n == 0 ? 2 * cutoff :
+	                          sin (2 * M_PI * cutoff * n) / (M_PI * n);
+	         float	window	= 0.42 -
+	                          0.5 * cos (2 * M_PI * i / (s. length - 1)) +
+	                          0.08 * cos (4 * M_PI * i / (s. length - 1));
+	         s. taps [i]	= sinc * window;
+	         sum		+= s. taps [i];
+	      }
+	      for (int i = 0; i < s. length; i ++)
+	         s. taps [i] /= sum;
+	      stages. push_back (s);
+	      d /= f;
+	   }
+	}
+}
+
+	ddcChannel::~ddcChannel	() {}
+
+int	ddcChannel::outRate	() {
+	return inRate / decimation;
+}
+
+int	ddcChannel::offset	() {
+	return theOffset;
+}
+
+void	ddcChannel::setGranularity	(int g) {
+	granularity	= g < 1 ? 1 : g;
+}
+//
+//	the history is stored twice, so the last "length" samples
+//	are always contiguous
+bool	ddcChannel::pass	(decimator &s, std::complex<float> &v) {
+	s. history [s. index]		= v;
+	s. history [s. index + s. length] = v;
+	s. index	= (s. index + 1) % s. length;
+	if (++ s. phase < s. factor)
+	   return false;
+	s. phase	= 0;
+const std::complex<float> *h	= &s. history [s. index];
+float	re	= 0;
+float	im	= 0;
+	for (int i = 0; i < s. length; i ++) {
+	   re	+= s. taps [i] * real (h [i]);
+	   im	+= s. taps [i] * imag (h [i]);
+	}
+	v	= std::complex<float> (re, im);
+	return true;
+}
+
+static inline
+int16_t	clamp_16	(float v) {
+	return v < -32768 ? -32768 : v > 32767 ? 32767 : (int16_t)lrintf (v);
+}
+
+int	ddcChannel::process	(const std::complex<int16_t> *in, int n,
+	                                 std::complex<int16_t> *out) {
+int	produced	= 0;
+	for (auto &p : pending)
+	   out [produced ++] = p;
+	pending. resize (0);
+	for (int i = 0; i < n; i ++) {
+	   std::complex<float> v = std::complex<float> (real (in [i]),
+	                                                imag (in [i])) * phasor;
+	   phasor	*= rotator;
+	   if (++ renormCount >= RENORM_SAMPLES) {	// keep it on the unit circle
+	      phasor	/= abs (phasor);
+	      renormCount	= 0;
+	   }
+	   bool	ready	= true;
+	   for (auto &s : stages)
+	      if (!(ready = pass (s, v)))
+	         break;
+	   if (ready)
+	      out [produced ++] = std::complex<int16_t> (clamp_16 (real (v)),
+	                                                 clamp_16 (imag (v)));
+	}
+	int keep	= produced % granularity;
+	for (int i = produced - keep; i < produced; i ++)
+	   pending. push_back (out [i]);
+	return produced - keep;
+}
+
@@ -0,0 +1,70 @@
+#
+/*
+ *    Copyright (C) 2025
+ *    Jan van Katwijk (J.vanKatwijk@gmail.com)
+ *    Lazy Chair Computing
+ *
+ *    This file is part of sdrplay_tcp
+ *
+ *    sdrplay_tcp is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    sdrplay_tcp is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with sdrplay_tcp; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#pragma once
+
+#include	<stdint.h>
+#include	<complex>
+#include	<vector>
+
+//
+//	A digital down converter: a narrow channel, "offset" Hz from
+//	the center of the wideband input, is shifted to 0 Hz (NCO) and
+//	decimated. The decimation is an integer, the largest one giving
+//	at least the requested rate, and is done in stages of at most 8,
+//	each with its own (windowed sinc) lowpass filter, only the
+//	samples that are kept are computed.
+//	The output is int16, scaled as the input.
+class	ddcChannel {
+public:
+		ddcChannel	(int inRate, int offset, int outRate);
+		~ddcChannel	();
+	int	outRate		();
+	int	offset		();
+	void	setGranularity	(int);
+//
+//	"out" needs room for n / decimation + granularity samples,
+//	the number of samples returned is a multiple of the granularity
+	int	process		(const std::complex<int16_t> *in, int n,
+	                                    std::complex<int16_t> *out);
+private:
+	struct	decimator {
+	   int		factor;
+	   int		length;
+	   std::vector<float>	taps;
+	   std::vector<std::complex<float>>	history;
+	   int		index;
+	   int		phase;
+	};
+	int		inRate;
+	int		theOffset;
+	int		decimation;
+	int		granularity;
+	std::vector<decimator>	stages;
+	std::complex<float>	phasor;
+	std::complex<float>	rotator;
+	int		renormCount;
+	std::vector<std::complex<int16_t>>	pending;
+	bool		pass		(decimator &, std::complex<float> &);
+};
+
@@ -0,0 +1,168 @@
+#
+/*
+ *    Copyright (C) 2025
+ *    Jan van Katwijk (J.vanKatwijk@gmail.com)
+ *    Lazy Chair Computing
+ *
+ *    This file is part of sdrplay_tcp
+ *
+ *    sdrplay_tcp is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    sdrplay_tcp is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with sdrplay_tcp; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include	"fb-channelizer.h"
+#include	<math.h>
+
+//
+//	the prototype filter is a windowed sinc (Blackman), with
+//	its -6 dB point halfway between two channels
+	fbChannelizer::fbChannelizer	(int inRate, int nrChannels,
+	                                 int oversampling, int tapsPerBranch) {
+	if (nrChannels < 2)
+	   nrChannels = 2;
+	if ((oversampling != 2) || (nrChannels % 2 != 0))
+	   oversampling = 1;
+	if (tapsPerBranch < 2)
+	   tapsPerBranch = 2;
+	this	-> inRate	= inRate;
+	this	-> nrChannels	= nrChannels;
+	hop		= nrChannels / oversampling;
+	length		= nrChannels * tapsPerBranch;
+	prototype. resize (length);
+float	sum	= 0;
+	for (int i = 0; i < length; i ++) {
+	   float n	= i - (length - 1) / 2.0;
+	   float sinc	= n == 0 ? 1.0 / nrChannels :
+	                     sin (M_PI * n / nrChannels) / (M_PI * n);
+	   float window	= 0.42 - 0.5 * cos (2 * M_PI * i / (length - 1)) +
+	                         0.08 * cos (4 * M_PI * i / (length - 1));
+	   prototype [i] = sinc * window;
+	   sum		+= prototype [i];
+	}
+	for (int i = 0; i < length; i ++)
+	   prototype [i] /= sum;
+	history. resize (2 * length);
+	histIndex	= 0;
+	inHop		= 0;
+	hopCounter	= 0;
+	fftVector	= (std::complex<float> *)
+	             FFTW_MALLOC (sizeof (std::complex<float>) * nrChannels);
+	plan	= FFTW_PLAN_DFT_1D (nrChannels,
+	                            reinterpret_cast <fftwf_complex *>(fftVector),
+	                            reinterpret_cast <fftwf_complex *>(fftVector),
+	                            FFTW_BACKWARD, FFTW_ESTIMATE);
+	active. resize (nrChannels, false);
+	outputs. resize (nrChannels);
+	twiddle. resize (nrChannels);
+	for (int i = 0; i < nrChannels; i ++)
+	   twiddle [i] = std::complex<float> (cos (-2 * M_PI * i / nrChannels),
+	                                      sin (-2 * M_PI * i / nrChannels));
+}
+
+	fbChannelizer::~fbChannelizer	() {
+	FFTW_DESTROY_PLAN (plan);
+	FFTW_FREE (fftVector);
+}
+
+int	fbChannelizer::channels	() {
+	return nrChannels;
+}
+
+int	fbChannelizer::spacing	() {
+	return inRate / nrChannels;
+}
+
+int	fbChannelizer::outRate	() {
+	return inRate / hop;
+}
+
+bool	fbChannelizer::validChannel	(int channel) {
+	return (channel >= - nrChannels / 2) && (channel < nrChannels / 2);
+}
+
+int	fbChannelizer::bin	(int channel) {
+	return (channel + nrChannels) % nrChannels;
+}
+
+void	fbChannelizer::clearActive	() {
+	for (int i = 0; i < nrChannels; i ++)
+	   active [i] = false;
+}
+
+void	fbChannelizer::setActive	(int channel) {
+	if (validChannel (channel))
+	   active [bin (channel)] = true;
+}
+//
+//	the output of the last call of process
+int	fbChannelizer::output	(int channel,
+	                         const std::complex<int16_t> **v) {
+	if (!validChannel (channel))
+	   return 0;
+	*v	= outputs [bin (channel)]. data ();
+	return outputs [bin (channel)]. size ();
+}
+
+void	fbChannelizer::process	(const std::complex<int16_t> *v, int n) {
+	for (int i = 0; i < nrChannels; i ++)
+	   outputs [i]. resize (0);
+	for (int i = 0; i < n; i ++) {
+//	the history is stored twice, the newest sample last
+	   std::complex<float> x (real (v [i]), imag (v [i]));
+	   history [histIndex]		= x;
+	   history [histIndex + length]	= x;
+	   histIndex	= (histIndex + 1) % length;
+	   if (++ inHop >= hop) {
+	      inHop	= 0;
+	      doHop ();
+	   }
+	}
+}
+
+static inline
+int16_t	clamp_16	(float v) {
+	return v < -32768 ? -32768 : v > 32767 ? 32767 : (int16_t)lrintf (v);
+}
+//
+//	y_m = exp (-j 2 pi m nD / M) sum_k exp (j 2 pi m k / M) u [k]
+//	with u [k] = sum_p h [k + pM] x [nD - k - pM],
+//	i.e. an inverse FFT of the polyphase sums, followed by a phase
+//	correction that is only needed when oversampling
+void	fbChannelizer::doHop	() {
+const std::complex<float> *h	= &history [histIndex];	// oldest first
+	for (int k = 0; k < nrChannels; k ++) {
+	   float re	= 0;
+	   float im	= 0;
+	   for (int r = k; r < length; r += nrChannels) {
+	      const std::complex<float> &x = h [length - 1 - r];
+	      re	+= prototype [r] * real (x);
+	      im	+= prototype [r] * imag (x);
+	   }
+	   fftVector [k] = std::complex<float> (re, im);
+	}
+	FFTW_EXECUTE (plan);
+	int	shift	= (hopCounter * hop) % nrChannels;
+	hopCounter ++;
+	for (int m = 0; m < nrChannels; m ++) {
+	   if (!active [m])
+	      continue;
+	   std::complex<float> y	= fftVector [m];
+	   int	rot	= (m * shift) % nrChannels;
+	   if (rot != 0)
+	      y	*= twiddle [rot];
+	   outputs [m]. push_back (std::complex<int16_t> (clamp_16 (real (y)),
+	                                                  clamp_16 (imag (y))));
+	}
+}
+
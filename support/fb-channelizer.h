@@ -0,0 +1,73 @@
+#
+/*
+ *    Copyright (C) 2025
+ *    Jan van Katwijk (J.vanKatwijk@gmail.com)
+ *    Lazy Chair Computing
+ *
+ *    This file is part of sdrplay_tcp
+ *
+ *    sdrplay_tcp is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    sdrplay_tcp is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with sdrplay_tcp; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#pragma once
+
+#include	<stdint.h>
+#include	<complex>
+#include	<vector>
+#include	"fft.h"
+
+//
+//	A polyphase (FFT) filter bank, splitting the input into
+//	nrChannels channels, evenly spaced at inRate / nrChannels.
+//	Channel c (-nrChannels / 2 .. nrChannels / 2 - 1) is centered
+//	at c * spacing from the center of the input and delivered at
+//	baseband, at a rate of oversampling * spacing.
+//	Per output sample period the cost is one FFT and
+//	nrChannels * tapsPerBranch multiplications, however many
+//	channels are in use.
+//	Only the channels marked active are kept, as int16,
+//	scaled as the input.
+class	fbChannelizer {
+public:
+		fbChannelizer	(int inRate, int nrChannels,
+	                         int oversampling, int tapsPerBranch);
+		~fbChannelizer	();
+	int	channels	();
+	int	spacing		();
+	int	outRate		();
+	bool	validChannel	(int);
+	void	clearActive	();
+	void	setActive	(int channel);
+	void	process		(const std::complex<int16_t> *, int);
+	int	output		(int channel, const std::complex<int16_t> **);
+private:
+	int		inRate;
+	int		nrChannels;
+	int		hop;
+	int		length;
+	std::vector<float>	prototype;
+	std::vector<std::complex<float>>	history;
+	int		histIndex;
+	int		inHop;
+	uint64_t	hopCounter;
+	std::complex<float>	*fftVector;
+	FFTW_PLAN	plan;
+	std::vector<std::complex<float>>	twiddle;
+	std::vector<bool>	active;
+	std::vector<std::vector<std::complex<int16_t>>>	outputs;
+	void		doHop		();
+	int		bin		(int channel);
+};
+
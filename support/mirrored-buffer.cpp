@@ -0,0 +1,104 @@
+#
+/*
+ *    Copyright (C) 2025
+ *    Jan van Katwijk (J.vanKatwijk@gmail.com)
+ *    Lazy Chair Computing
+ *
+ *    This file is part of sdrplay_tcp
+ *
+ *    sdrplay_tcp is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    sdrplay_tcp is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with sdrplay_tcp; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include	"mirrored-buffer.h"
+#include	<stdio.h>
+#ifdef	__linux__
+#include	<sys/mman.h>
+#include	<unistd.h>
+#include	<errno.h>
+#include	<string.h>
+#endif
+
+	mirroredBuffer::mirroredBuffer	(size_t size) {
+	this	-> size	= size;
+	mirrored	= mapMirrored ();
+	if (!mirrored)
+	   buffer	= new char [size];
+}
+
+	mirroredBuffer::~mirroredBuffer	() {
+#ifdef	__linux__
+	if (mirrored) {
+	   munmap (buffer, 2 * size);
+	   return;
+	}
+#endif
+	delete [] buffer;
+}
+
+char	*mirroredBuffer::data	() {
+	return buffer;
+}
+
+bool	mirroredBuffer::isMirrored	() {
+	return mirrored;
+}
+//
+//	An anonymous file (memfd) of the given size is mapped into
+//	the two halves of a reserved range of twice that size. Once
+//	mapped, the file descriptor is not needed anymore
+bool	mirroredBuffer::mapMirrored	() {
+#ifdef	__linux__
+long	pageSize	= sysconf (_SC_PAGESIZE);
+int	fd;
+void	*range;
+void	*first;
+void	*second;
+	if ((size == 0) || (pageSize <= 0) || (size % pageSize != 0))
+	   return false;
+	fd	= memfd_create ("ringbuffer", MFD_CLOEXEC);
+	if (fd < 0) {
+	   fprintf (stderr, "memfd_create fails (%s), ringbuffer not mirrored\n",
+	                                                 strerror (errno));
+	   return false;
+	}
+	if (ftruncate (fd, size) != 0) {
+	   fprintf (stderr, "ftruncate fails (%s), ringbuffer not mirrored\n",
+	                                                 strerror (errno));
+	   close (fd);
+	   return false;
+	}
+	range	= mmap (nullptr, 2 * size, PROT_NONE,
+	                MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (range == MAP_FAILED) {
+	   close (fd);
+	   return false;
+	}
+	first	= mmap (range, size, PROT_READ | PROT_WRITE,
+	                MAP_SHARED | MAP_FIXED, fd, 0);
+	second	= mmap ((char *)range + size, size, PROT_READ | PROT_WRITE,
+	                MAP_SHARED | MAP_FIXED, fd, 0);
+	close (fd);
+	if ((first != range) || (second != (char *)range + size)) {
+	   fprintf (stderr, "mmap fails (%s), ringbuffer not mirrored\n",
+	                                                 strerror (errno));
+	   munmap (range, 2 * size);
+	   return false;
+	}
+	buffer	= (char *)range;
+	return true;
+#else
+	return false;
+#endif
+}
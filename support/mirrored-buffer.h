@@ -0,0 +1,46 @@
+#
+/*
+ *    Copyright (C) 2025
+ *    Jan van Katwijk (J.vanKatwijk@gmail.com)
+ *    Lazy Chair Computing
+ *
+ *    This file is part of sdrplay_tcp
+ *
+ *    sdrplay_tcp is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    sdrplay_tcp is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with sdrplay_tcp; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#pragma once
+
+#include	<stddef.h>
+
+//
+//	The storage for a ringbuffer: on Linux the same pages are mapped
+//	twice, back to back, so data (i) and data (i + size) are the same
+//	byte and any span of up to size bytes, starting anywhere in the
+//	first mapping, is contiguous. The size should be a multiple of
+//	the page size, if it is not (or the mapping fails, or we are not
+//	on Linux) the storage is a plain, unmirrored, array.
+class	mirroredBuffer {
+public:
+		mirroredBuffer	(size_t size);
+		~mirroredBuffer	();
+	char	*data		();
+	bool	isMirrored	();
+private:
+	char	*buffer;
+	size_t	size;
+	bool	mirrored;
+	bool	mapMirrored	();
+};
@@ -0,0 +1,332 @@
+#
+/*
+ *    Copyright (C) 2025
+ *    Jan van Katwijk (J.vanKatwijk@gmail.com)
+ *    Lazy Chair Computing
+ *
+ *    This file is part of sdrplay_tcp
+ *
+ *    sdrplay_tcp is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    sdrplay_tcp is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with sdrplay_tcp; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include	"resampler.h"
+#include	"simd-kernels.h"
+#include	<math.h>
+#include	<map>
+#include	<mutex>
+#include	<numeric>
+#include	<algorithm>
+
+#define	MAX_PHASES	256
+#define	HALFBAND_TAPS	79		// 4 * k + 3, the outer taps non zero
+#define	STOPBAND	60		// dB, for the Kaiser windows
+#define	CHUNK_SIZE	4096		// input samples per pass
+
+static
+double	bessel_i0	(double x) {
+double	sum	= 1;
+double	term	= 1;
+	for (int k = 1; k < 50; k ++) {
+	   term	*= (x / (2 * k)) * (x / (2 * k));
+	   sum	+= term;
+	   if (term < 1e-12 * sum)
+	      break;
+	}
+	return sum;
+}
+//
+//	u in -1 .. 1
+static
+double	kaiser		(double u, double beta) {
+	if ((u < -1) || (u > 1))
+	   return 0;
+	return bessel_i0 (beta * sqrt (1 - u * u)) / bessel_i0 (beta);
+}
+
+static
+double	kaiserBeta	(double attenuation) {
+	return 0.1102 * (attenuation - 8.7);
+}
+//
+//	The half-band filter, cutoff at a quarter of the input rate:
+//	all even taps but the center one are zero. With 79 taps the
+//	band up to 0.227 of the input rate is free of aliases
+static
+std::vector<float>	designHalfband	() {
+std::vector<float> taps (HALFBAND_TAPS);
+int	center	= HALFBAND_TAPS / 2;
+double	beta	= kaiserBeta (STOPBAND);
+double	sum	= 0;
+	for (int i = 0; i < HALFBAND_TAPS; i ++) {
+	   int	n	= i - center;
+	   double h	= n == 0 ? 0.5 :
+	                  n % 2 == 0 ? 0 : sin (M_PI * n / 2) / (M_PI * n);
+	   taps [i]	= h * kaiser ((double)n / (center + 1), beta);
+	   sum		+= taps [i];
+	}
+	for (auto &t : taps)
+	   t /= sum;
+	return taps;
+}
+
+static
+const std::vector<float>	&halfbandTaps	() {
+static	std::vector<float> taps	= designHalfband ();
+	return taps;
+}
+//
+//	the non zero taps but the center one, all at even positions
+static
+const std::vector<float>	&halfbandEven	() {
+static	std::vector<float> taps	= [] () {
+	   std::vector<float> res;
+	   for (int i = 0; i < HALFBAND_TAPS; i += 2)
+	      res. push_back (halfbandTaps () [i]);
+	   return res;
+	} ();
+	return taps;
+}
+//
+//	Phase p of the bank computes the output at (T - 1) / 2 + p / P
+//	input samples after the start of its window of T input samples.
+//	The lowpass passes 0.4 of the output rate, and stops at 0.5
+static
+std::shared_ptr<const resamplerDesign>	makeDesign (int inRate, int outRate) {
+std::shared_ptr<resamplerDesign> d	= std::make_shared<resamplerDesign> ();
+int	rate	= inRate;
+	d -> halfbands	= 0;
+	while ((rate >= 2 * outRate) && (rate % 2 == 0)) {
+	   rate /= 2;
+	   d -> halfbands ++;
+	}
+	d -> step	= ((uint64_t)rate << 32) / outRate;
+	if (rate == outRate) {
+	   d -> phases	= 0;
+	   d -> taps	= 0;
+	   return d;
+	}
+	int	L	= outRate / std::gcd (rate, outRate);
+	d -> phases	= L <= MAX_PHASES ? L : MAX_PHASES;
+	double	ratio	= std::min (1.0, (double)outRate / rate);
+	double	cutoff	= 0.45 * ratio;		// of the input rate
+	double	width	= 0.1 * ratio;
+	int	T	= (int)ceil ((STOPBAND - 8) / (14.36 * width));
+	T		= (T + 7) & ~07;
+	d -> taps	= T;
+	d -> bank. resize (d -> phases * T);
+	double	beta	= kaiserBeta (STOPBAND);
+	for (int p = 0; p < d -> phases; p ++) {
+	   float *c	= &d -> bank [p * T];
+	   double sum	= 0;
+	   for (int k = 0; k < T; k ++) {
+	      double x	= k - (T - 1) / 2.0 - (double)p / d -> phases;
+	      double h	= x == 0 ? 2 * cutoff :
+	                       sin (2 * M_PI * cutoff * x) / (M_PI * x);
+	      c [k]	= h * kaiser (x / ((T + 1) / 2.0), beta);
+	      sum	+= c [k];
+	   }
+	   for (int k = 0; k < T; k ++)
+	      c [k] /= sum;
+	}
+	return d;
+}
+//
+//	the designs are shared by all resamplers with the same rates
+static
+std::shared_ptr<const resamplerDesign>	getDesign (int inRate, int outRate) {
+static	std::mutex	cacheLocker;
+static	std::map<std::pair<int, int>,
+	         std::shared_ptr<const resamplerDesign>> cache;
+	std::lock_guard<std::mutex> lock (cacheLocker);
+	auto	key	= std::pair<int, int> (inRate, outRate);
+	auto	it	= cache. find (key);
+	if (it != cache. end ())
+	   return it -> second;
+	std::shared_ptr<const resamplerDesign> d = makeDesign (inRate, outRate);
+	cache [key]	= d;
+	return d;
+}
+
+//
+//	The input is processed in chunks of at most CHUNK_SIZE samples,
+//	so all buffers can be allocated here: a stage never gets more
+//	than a chunk plus what is left from its window
+	resampler::resampler	(int inRate, int outRate) {
+int	capacity;
+	design		= getDesign (inRate, outRate);
+	capacity	= CHUNK_SIZE + std::max (HALFBAND_TAPS,
+	                                         design -> taps) + 4;
+	halfbandHistory. resize (design -> halfbands);
+	for (auto &h : halfbandHistory)
+	   allocate (h, 2 * capacity, HALFBAND_TAPS - 1);
+	if (design -> phases > 0)
+	   allocate (bankHistory, 2 * capacity, design -> taps - 1);
+	allocate (work [0], capacity, 0);
+	allocate (work [1], capacity, 0);
+	allocate (even, capacity, 0);
+	pending. reserve (capacity);
+	position	= 0;
+	pendingIndex	= 0;
+}
+
+	resampler::~resampler	() {}
+
+bool	resampler::changesRate	() {
+	return true;
+}
+
+int	resampler::nrHalfbands	() {
+	return design -> halfbands;
+}
+//
+//	a buffer starts with "history" zeros
+void	resampler::allocate	(buffer &b, int capacity, int history) {
+	b. re. assign (capacity, 0);
+	b. im. assign (capacity, 0);
+	b. start	= 0;
+	b. fill		= history;
+}
+//
+//	The history is twice as long as needed: only when the new
+//	samples do not fit behind the valid ones, the (few) samples
+//	not used yet are moved to the front
+void	resampler::append	(buffer &b, const buffer &in) {
+int	n	= in. fill - in. start;
+	if (b. fill + n > (int)b. re. size ()) {
+	   std::copy (b. re. begin () + b. start,
+	              b. re. begin () + b. fill, b. re. begin ());
+	   std::copy (b. im. begin () + b. start,
+	              b. im. begin () + b. fill, b. im. begin ());
+	   b. fill	-= b. start;
+	   b. start	= 0;
+	}
+	std::copy (in. re. begin () + in. start,
+	           in. re. begin () + in. fill, b. re. begin () + b. fill);
+	std::copy (in. im. begin () + in. start,
+	           in. im. begin () + in. fill, b. im. begin () + b. fill);
+	b. fill	+= n;
+}
+//
+//	each stage keeps in its history what it did not use yet, the
+//	part of the window of the next output that is already there.
+//	Only the even taps (and the center one) are non zero, so the
+//	samples at even positions are collected in a separate buffer,
+//	where the taps apply to contiguous samples
+void	resampler::halfband	(buffer &b, buffer &out) {
+const std::vector<float> &taps	= halfbandEven ();
+float	center	= halfbandTaps () [HALFBAND_TAPS / 2];
+const float *re	= &b. re [b. start];
+const float *im	= &b. im [b. start];
+int	size	= b. fill - b. start;
+int	start	= 0;
+int	n	= 0;
+	for (int i = 0; i < (size + 1) / 2; i ++) {
+	   even. re [i]	= re [2 * i];
+	   even. im [i]	= im [2 * i];
+	}
+	for (; start + HALFBAND_TAPS <= size; start += 2) {
+	   dotProduct2 (taps. data (), &even. re [n], &even. im [n],
+	                taps. size (), out. re [n], out. im [n]);
+	   out. re [n]	+= center * re [start + HALFBAND_TAPS / 2];
+	   out. im [n]	+= center * im [start + HALFBAND_TAPS / 2];
+	   n ++;
+	}
+	out. start	= 0;
+	out. fill	= n;
+	b. start	+= start;
+}
+
+void	resampler::fractional	(buffer &b, buffer &out) {
+const float *re	= &b. re [b. start];
+const float *im	= &b. im [b. start];
+int	size	= b. fill - b. start;
+int	T	= design -> taps;
+int	P	= design -> phases;
+int	n	= 0;
+int	used;
+	while (true) {
+	   uint64_t index	= position >> 32;
+	   uint64_t phase	= ((position & 0xFFFFFFFF) * P + (1ULL << 31)) >> 32;
+	   if (phase == (uint64_t)P) {
+	      index ++;
+	      phase	= 0;
+	   }
+	   if (index + T > (uint64_t)size)
+	      break;
+	   dotProduct2 (&design -> bank [phase * T],
+	                &re [index], &im [index], T,
+	                out. re [n], out. im [n]);
+	   n ++;
+	   position	+= design -> step;
+	}
+	out. start	= 0;
+	out. fill	= n;
+	used	= std::min ((int)(position >> 32), size);
+	position	-= ((uint64_t)used) << 32;
+	b. start	+= used;
+}
+
+static inline
+int16_t	clamp_16	(float v) {
+	return v < -32768 ? -32768 : v > 32767 ? 32767 : (int16_t)lrintf (v);
+}
+//
+//	The input is used chunk by chunk, until it is all used or
+//	"out" is full. What the last chunk produced that does not fit
+//	in "out" waits for the next call
+int	resampler::process	(const std::complex<int16_t> *in, int n,
+	                         std::complex<int16_t> *out, int maxOut,
+	                                                 int &nOut) {
+int	used	= 0;
+	nOut	= 0;
+	while ((pendingIndex < (int)pending. size ()) && (nOut < maxOut))
+	   out [nOut ++] = pending [pendingIndex ++];
+	if (pendingIndex < (int)pending. size ())
+	   return 0;
+	pending. resize (0);
+	pendingIndex	= 0;
+
+	while ((used < n) && (nOut < maxOut)) {
+	   buffer *current	= &work [0];
+	   buffer *next		= &work [1];
+	   int	amount		= std::min (CHUNK_SIZE, n - used);
+	   for (int i = 0; i < amount; i ++) {
+	      current -> re [i]	= real (in [used + i]);
+	      current -> im [i]	= imag (in [used + i]);
+	   }
+	   current -> start	= 0;
+	   current -> fill	= amount;
+	   used	+= amount;
+	   for (auto &h : halfbandHistory) {
+	      append (h, *current);
+	      halfband (h, *next);
+	      std::swap (current, next);
+	   }
+	   if (design -> phases > 0) {
+	      append (bankHistory, *current);
+	      fractional (bankHistory, *next);
+	      std::swap (current, next);
+	   }
+	   for (int i = 0; i < current -> fill; i ++) {
+	      std::complex<int16_t> v (clamp_16 (current -> re [i]),
+	                               clamp_16 (current -> im [i]));
+	      if (nOut < maxOut)
+	         out [nOut ++] = v;
+	      else
+	         pending. push_back (v);
+	   }
+	}
+	return used;
+}
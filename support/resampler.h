@@ -0,0 +1,79 @@
+#
+/*
+ *    Copyright (C) 2025
+ *    Jan van Katwijk (J.vanKatwijk@gmail.com)
+ *    Lazy Chair Computing
+ *
+ *    This file is part of sdrplay_tcp
+ *
+ *    sdrplay_tcp is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    sdrplay_tcp is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with sdrplay_tcp; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#pragma once
+
+#include	<stdint.h>
+#include	<complex>
+#include	<vector>
+#include	<memory>
+#include	"base-converter.h"
+
+//
+//	Rate conversion from inRate to (a lower) outRate. As long as
+//	the ratio is at least 2 the rate is halved by half-band filters,
+//	the remaining ratio (between 1 and 2) is done by a polyphase
+//	filter bank. For a rational ratio with a small numerator the
+//	bank has exactly the phases needed, otherwise it has MAX_PHASES
+//	phases and the nearest one is taken.
+//	The filters depend only on the two rates, they are designed once
+//	and kept in a cache, so a rate change costs no design work.
+struct	resamplerDesign {
+	int	halfbands;		// nr of decimate by 2 stages
+	int	phases;			// 0: no fractional stage
+	int	taps;			// per phase, multiple of 8
+	uint64_t step;			// input samples per output, 32.32
+	std::vector<float>	bank;	// phases * taps
+};
+
+class	resampler: public baseConverter {
+public:
+		resampler	(int inRate, int outRate);
+		~resampler	();
+	int	process		(const std::complex<int16_t> *in, int n,
+	                         std::complex<int16_t> *out, int maxOut,
+	                                                 int &nOut);
+	bool	changesRate	();
+	int	nrHalfbands	();
+private:
+//	the samples start .. fill - 1 are valid, start is the read offset
+	struct	buffer {
+	   std::vector<float>	re;
+	   std::vector<float>	im;
+	   int			start;
+	   int			fill;
+	};
+	std::shared_ptr<const resamplerDesign>	design;
+	std::vector<buffer>	halfbandHistory;
+	buffer			bankHistory;
+	uint64_t		position;	// in bankHistory, 32.32
+	buffer			work [2];
+	buffer			even;
+	std::vector<std::complex<int16_t>>	pending;
+	int			pendingIndex;
+	void	allocate	(buffer &, int capacity, int history);
+	void	append		(buffer &, const buffer &);
+	void	halfband	(buffer &, buffer &out);
+	void	fractional	(buffer &, buffer &out);
+};
+
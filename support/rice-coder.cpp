@@ -0,0 +1,220 @@
+#
+/*
+ *    Copyright (C) 2025
+ *    Jan van Katwijk (J.vanKatwijk@gmail.com)
+ *    Lazy Chair Computing
+ *
+ *    This file is part of sdrplay_tcp
+ *
+ *    sdrplay_tcp is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    sdrplay_tcp is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with sdrplay_tcp; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include	"rice-coder.h"
+
+//
+//	a unary part of ESCAPE ones is followed by the raw value,
+//	the difference of two 16 bit values fits in 17 bits
+#define	ESCAPE		32
+#define	RAW_BITS	17
+
+static inline
+uint32_t zigzag	(int32_t v) {
+	return (uint32_t)((v << 1) ^ (v >> 31));
+}
+
+static inline
+int32_t	unzigzag	(uint32_t u) {
+	return (int32_t)(u >> 1) ^ -(int32_t)(u & 1);
+}
+
+//	bits are written msb first
+class	bitWriter {
+public:
+	bitWriter	(uint8_t *out) {
+	   this	-> out	= out;
+	   acc		= 0;
+	   inAcc	= 0;
+	   written	= 0;
+	}
+	void	put	(uint32_t bits, int n) {	// n <= 32
+	   acc	= (acc << n) | (bits & (n == 32 ? 0xFFFFFFFF :
+	                                         ((1u << n) - 1)));
+	   inAcc	+= n;
+	   while (inAcc >= 8) {
+	      inAcc -= 8;
+	      out [written ++] = (acc >> inAcc) & 0xFF;
+	   }
+	}
+	int	close	() {
+	   if (inAcc > 0)
+	      out [written ++] = (acc << (8 - inAcc)) & 0xFF;
+	   inAcc	= 0;
+	   return written;
+	}
+private:
+	uint8_t	*out;
+	uint64_t acc;
+	int	inAcc;
+	int	written;
+};
+
+class	bitReader {
+public:
+	bitReader	(const uint8_t *in, int size) {
+	   this	-> in	= in;
+	   this	-> size	= size;
+	   acc		= 0;
+	   inAcc	= 0;
+	   used		= 0;
+	}
+	uint32_t get	(int n) {
+	   while (inAcc < n) {
+	      acc	= (acc << 8) | (used < size ? in [used] : 0);
+	      used ++;
+	      inAcc	+= 8;
+	   }
+	   inAcc	-= n;
+	   return (acc >> inAcc) & ((1ull << n) - 1);
+	}
+private:
+	const uint8_t *in;
+	int	size;
+	uint64_t acc;
+	int	inAcc;
+	int	used;
+};
+
+int	maxFrameSize	(int nrSamples) {
+	return FRAME_HEADER_SIZE + (2 * nrSamples * (ESCAPE + RAW_BITS) + 7) / 8;
+}
+//
+//	the Rice parameter is derived from the mean of the values,
+//	k such that 2^k is about the mean
+static
+int	riceParameter	(const uint32_t *u, int n) {
+uint64_t sum	= 0;
+int	k	= 0;
+	for (int i = 0; i < n; i ++)
+	   sum += u [i];
+	while ((k < 16) && (((uint64_t)n << (k + 1)) < sum))
+	   k ++;
+	return k;
+}
+
+static inline
+void	put_value	(bitWriter &w, uint32_t u, int k) {
+uint32_t q	= u >> k;
+	if (q >= ESCAPE) {
+	   w. put (0xFFFFFFFF, ESCAPE);
+	   w. put (u, RAW_BITS);
+	   return;
+	}
+	w. put (((1u << q) - 1) << 1, q + 1);	// q ones and a zero
+	if (k > 0)
+	   w. put (u, k);
+}
+
+//
+//	For (nearly) white noise the differences are larger than the
+//	values themselves, so per block we take whichever of the two,
+//	the values or the differences, gives the smaller sum
+int	encodeFrame	(const std::complex<int16_t> *in, int n,
+	                 int nrBits, int loss, uint8_t *frame,
+	                 uint32_t *work) {
+const int16_t *v	= (const int16_t *)in;
+uint32_t *u	= work;
+uint32_t *d	= work + 2 * n;
+uint64_t sumU	= 0;
+uint64_t sumD	= 0;
+int32_t	prevI	= 0;
+int32_t	prevQ	= 0;
+	for (int i = 0; i < n; i ++) {
+	   int32_t x	= v [2 * i] >> loss;
+	   int32_t y	= v [2 * i + 1] >> loss;
+	   u [2 * i]	= zigzag (x);
+	   u [2 * i + 1] = zigzag (y);
+	   d [2 * i]	= zigzag (x - prevI);
+	   d [2 * i + 1] = zigzag (y - prevQ);
+	   sumU		+= u [2 * i] + u [2 * i + 1];
+	   sumD		+= d [2 * i] + d [2 * i + 1];
+	   prevI	= x;
+	   prevQ	= y;
+	}
+	bool	delta	= sumD < sumU;
+	uint32_t *values	= delta ? d : u;
+	int k	= riceParameter (values, 2 * n);
+	bitWriter w (&frame [FRAME_HEADER_SIZE]);
+	for (int i = 0; i < 2 * n; i ++)
+	   put_value (w, values [i], k);
+	int payload	= w. close ();
+	frame [0]	= 'I';
+	frame [1]	= 'Q';
+	frame [2]	= nrBits;
+	frame [3]	= k;
+	frame [4]	= (n >> 8) & 0xFF;
+	frame [5]	= n & 0xFF;
+	frame [6]	= (payload >> 24) & 0xFF;
+	frame [7]	= (payload >> 16) & 0xFF;
+	frame [8]	= (payload >> 8) & 0xFF;
+	frame [9]	= payload & 0xFF;
+	frame [10]	= loss;
+	frame [11]	= delta ? 1 : 0;
+	return FRAME_HEADER_SIZE + payload;
+}
+
+int	frameSize	(const uint8_t *frame, int available) {
+int	payload;
+	if (available < FRAME_HEADER_SIZE)
+	   return -1;
+	payload	= (frame [6] << 24) | (frame [7] << 16) |
+	          (frame [8] << 8) | frame [9];
+	if (available < FRAME_HEADER_SIZE + payload)
+	   return -1;
+	return FRAME_HEADER_SIZE + payload;
+}
+
+int	decodeFrame	(const uint8_t *frame, int size,
+	                 std::complex<int16_t> *out) {
+int	k	= frame [3];
+int	n	= (frame [4] << 8) | frame [5];
+int	loss	= frame [10];
+bool	delta	= frame [11] != 0;
+int32_t	prev [2] = {0, 0};
+	if ((frame [0] != 'I') || (frame [1] != 'Q') ||
+	                        (frameSize (frame, size) < 0))
+	   return -1;
+	bitReader r (&frame [FRAME_HEADER_SIZE], size - FRAME_HEADER_SIZE);
+	for (int i = 0; i < 2 * n; i ++) {
+	   uint32_t q	= 0;
+	   uint32_t u;
+	   while ((q < ESCAPE) && (r. get (1) == 1))
+	      q ++;
+	   if (q == ESCAPE)
+	      u	= r. get (RAW_BITS);
+	   else
+	      u	= (q << k) | (k > 0 ? r. get (k) : 0);
+	   if (delta)
+	      prev [i & 01] += unzigzag (u);
+	   else
+	      prev [i & 01] = unzigzag (u);
+	   int32_t x	= prev [i & 01] * (1 << loss);
+	   if (i & 01)
+	      out [i / 2]. imag (x);
+	   else
+	      out [i / 2]. real (x);
+	}
+	return n;
+}
+
@@ -0,0 +1,57 @@
+#
+/*
+ *    Copyright (C) 2025
+ *    Jan van Katwijk (J.vanKatwijk@gmail.com)
+ *    Lazy Chair Computing
+ *
+ *    This file is part of sdrplay_tcp
+ *
+ *    sdrplay_tcp is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    sdrplay_tcp is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with sdrplay_tcp; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#pragma once
+
+#include	<stdint.h>
+#include	<complex>
+
+//
+//	A simple, fast and lossless coder for IQ samples.
+//	I and Q are, if that pays off, delta coded (a block starts from 0,
+//	so each block can be decoded on its own), the values are mapped
+//	to unsigned values (zigzag) and Rice coded with a parameter
+//	computed per block. Near lossless operation is by dropping
+//	"loss" low order bits before coding.
+//
+//	A frame is a 12 byte header followed by the coded bits:
+//	'I', 'Q', nrBits, k, nrSamples (2 bytes), payload size (4 bytes),
+//	loss, delta (0 or 1), multibyte values are big endian
+#define	FRAME_HEADER_SIZE	12
+
+int	maxFrameSize	(int nrSamples);
+//
+//	returns the size of the frame in bytes, "work" is scratch space
+//	for 4 * nrSamples values, provided by the caller so that coding
+//	does not use the stack or allocate
+int	encodeFrame	(const std::complex<int16_t> *, int nrSamples,
+	                 int nrBits, int loss, uint8_t *frame,
+	                 uint32_t *work);
+//
+//	returns the total frame size, -1 if the frame is incomplete
+int	frameSize	(const uint8_t *frame, int available);
+//
+//	the reference decoder, returns the number of samples
+int	decodeFrame	(const uint8_t *frame, int size,
+	                 std::complex<int16_t> *out);
+
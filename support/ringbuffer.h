@@ -72,67 +72,57 @@
 #include	<stdio.h>
 #include	<string.h>
 #include	<stdint.h>
+#include	<atomic>
+#include	"mirrored-buffer.h"
 /*
  *	a simple ringbuffer, lockfree, however only for a
  *	single reader and a single writer.
  *	Mostly used for getting samples from or to the soundcard
+ *
+ *	The indices are free running counters, the position in the
+ *	buffer is the index masked with bufferSize - 1, the nr of
+ *	elements in the buffer is writeIndex - readIndex (modulo 2^32,
+ *	bufferSize is a power of two).
+ *	The writer publishes the elements with a release store of the
+ *	writeIndex, the reader acquires it before reading them, the
+ *	same holds the other way around for the readIndex and the
+ *	space. Each side keeps a copy of the index of the other side
+ *	and only looks at the real one when the copy does not give
+ *	enough data or space, the copy is never ahead of the real index.
+ *	The two sides are on different cache lines.
+ *
+ *	Where possible (Linux) the storage is mapped twice, back to
+ *	back, a region then never wraps and the second region returned
+ *	by the Get...Regions functions is always empty.
  */
-#if defined(__APPLE__)
-#   include <libkern/OSAtomic.h>
-    /* Here are the memory barrier functions. Mac OS X only provides
-       full memory barriers, so the three types of barriers are the same,
-       however, these barriers are superior to compiler-based ones. */
-#   define PaUtil_FullMemoryBarrier()  OSMemoryBarrier()
-#   define PaUtil_ReadMemoryBarrier()  OSMemoryBarrier()
-#   define PaUtil_WriteMemoryBarrier() OSMemoryBarrier()
-#elif defined(__GNUC__)
-    /* GCC >= 4.1 has built-in intrinsics. We'll use those */
-#   if (__GNUC__ > 4) || (__GNUC__ == 4 && __GNUC_MINOR__ >= 1)
-# define PaUtil_FullMemoryBarrier()  __sync_synchronize()
-# define PaUtil_ReadMemoryBarrier()  __sync_synchronize()
-# define PaUtil_WriteMemoryBarrier() __sync_synchronize()
-    /* as a fallback, GCC understands volatile asm and "memory" to mean it
-     * should not reorder memory read/writes */
-#   elif defined( __PPC__ )
-#      define PaUtil_FullMemoryBarrier()  asm volatile("sync":::"memory")
-#      define PaUtil_ReadMemoryBarrier()  asm volatile("sync":::"memory")
-#      define PaUtil_WriteMemoryBarrier() asm volatile("sync":::"memory")
-#   elif defined( __i386__ ) || defined( __i486__ ) || defined( __i586__ ) || defined( __i686__ ) || defined( __x86_64__ )
-#      define PaUtil_FullMemoryBarrier()  asm volatile("mfence":::"memory")
-#      define PaUtil_ReadMemoryBarrier()  asm volatile("lfence":::"memory")
-#      define PaUtil_WriteMemoryBarrier() asm volatile("sfence":::"memory")
-#   else
-#      ifdef ALLOW_SMP_DANGERS
-#         warning Memory barriers not defined on this system or system unknown
-#         warning For SMP safety, you should fix this.
-#         define PaUtil_FullMemoryBarrier()
-#         define PaUtil_ReadMemoryBarrier()
-#         define PaUtil_WriteMemoryBarrier()
-#      else
-#         error Memory barriers are not defined on this system. You can still compile by defining ALLOW_SMP_DANGERS, but SMP safety will not be guaranteed.
-#      endif
-#   endif
-#else
-#   ifdef ALLOW_SMP_DANGERS
-#      warning Memory barriers not defined on this system or system unknown
-#      warning For SMP safety, you should fix this.
-#      define PaUtil_FullMemoryBarrier()
-#      define PaUtil_ReadMemoryBarrier()
-#      define PaUtil_WriteMemoryBarrier()
-#   else
-#      error Memory barriers are not defined on this system. You can still compile by defining ALLOW_SMP_DANGERS, but SMP safety will not be guaranteed.
-#   endif
-#endif
+#define	RING_CACHE_LINE	64
 
 template <class elementtype>
 class RingBuffer {
 private:
 		uint32_t	bufferSize;
-volatile	uint32_t	writeIndex;
-volatile	uint32_t	readIndex;
-		uint32_t	bigMask;
 	        uint32_t	smallMask;
 		char		*buffer;
+		mirroredBuffer	*storage;
+		bool		mirrored;
+//	the writer side
+alignas (RING_CACHE_LINE)
+	std::atomic<uint32_t>	writeIndex;
+		uint32_t	cachedReadIndex;
+//	the reader side
+alignas (RING_CACHE_LINE)
+	std::atomic<uint32_t>	readIndex;
+		uint32_t	cachedWriteIndex;
+		char		padding [RING_CACHE_LINE - sizeof (uint32_t) -
+	                                  sizeof (std::atomic<uint32_t>)];
+
+//	with a Flush racing a reader the indices may (briefly) be off,
+//	the amount is clamped so that we never go outside the buffer
+	uint32_t	clamp		(uint32_t amount) {
+	   if (amount > 0x80000000U)	// negative
+	      return 0;
+	   return amount > bufferSize ? bufferSize : amount;
+	}
 public:
 	RingBuffer (uint32_t elementCount) {
 	if (((elementCount - 1) & elementCount) != 0) {
@@ -145,23 +135,32 @@ public:
 	else
 	   bufferSize = elementCount;
 
-	buffer		= new char [2 * bufferSize * sizeof (elementtype)];
-	writeIndex	= 0;
-	readIndex	= 0;
-	smallMask	= (bufferSize)- 1;
-	bigMask		= (bufferSize * 2) - 1;
+	storage		= new mirroredBuffer (bufferSize * sizeof (elementtype));
+	buffer		= storage -> data ();
+	mirrored	= storage -> isMirrored ();
+	writeIndex. store (0);
+	readIndex. store (0);
+	cachedReadIndex		= 0;
+	cachedWriteIndex	= 0;
+	smallMask	= bufferSize - 1;
 }
 
 	~RingBuffer () {
-	   delete[]	 buffer;
+	   delete	storage;
+}
+//
+//	true if any span up to the size of the buffer is contiguous
+bool	isContiguous	() {
+	return mirrored;
 }
 
 /*
  * 	functions for checking available data for reading and space
- * 	for writing
+ * 	for writing, they may be called from any thread
  */
 uint32_t	GetRingBufferReadAvailable (void) {
-	return (writeIndex - readIndex) & bigMask;
+uint32_t r	= readIndex. load (std::memory_order_acquire);
+	return clamp (writeIndex. load (std::memory_order_acquire) - r);
 }
 
 //int32_t	ReadSpace	(void){
@@ -175,26 +174,28 @@ uint32_t	GetRingBufferWriteAvailable (void) {
 int32_t	WriteSpace	(void) {
 	return GetRingBufferWriteAvailable ();
 }
-
+//
+//	Flushing skips all data written so far, the indices themselves
+//	are never reset, so the copies of the two sides stay valid
 void	FlushRingBuffer () {
-	writeIndex	= 0;
-	readIndex	= 0;
+	readIndex. store (writeIndex. load (std::memory_order_acquire),
+	                                         std::memory_order_release);
 }
-/* ensure that previous writes are seen before we update the write index 
-   (write after write)
+/* the elements written are published by the release store
  */
 int32_t AdvanceRingBufferWriteIndex (int32_t elementCount) {
-	PaUtil_WriteMemoryBarrier();
-	return writeIndex = (writeIndex + elementCount) & bigMask;
+uint32_t w	= writeIndex. load (std::memory_order_relaxed) + elementCount;
+	writeIndex. store (w, std::memory_order_release);
+	return w & smallMask;
 }
 
-/* ensure that previous reads (copies out of the ring buffer) are
- * always completed before updating (writing) the read index. 
- * (write-after-read) => full barrier
+/* the reads from the buffer are complete before the release store
+ * hands the space back to the writer
  */
 int32_t AdvanceRingBufferReadIndex (int32_t elementCount) {
-    PaUtil_FullMemoryBarrier();
-    return readIndex = (readIndex + elementCount) & bigMask;
+uint32_t r	= readIndex. load (std::memory_order_relaxed) + elementCount;
+	readIndex. store (r, std::memory_order_release);
+	return r & smallMask;
 }
 
 /***************************************************************************
@@ -202,19 +203,26 @@ int32_t AdvanceRingBufferReadIndex (int32_t elementCount) {
 ** If the region is contiguous, size2 will be zero.
 ** If non-contiguous, size2 will be the size of second region.
 ** Returns room available to be written or elementCount, whichever is smaller.
+** Only to be called by the writer.
 */
 int32_t GetRingBufferWriteRegions (uint32_t elementCount,
                                    void **dataPtr1, int32_t *sizePtr1,
                                    void **dataPtr2, int32_t *sizePtr2 ) {
 uint32_t   index;
-uint32_t   available = GetRingBufferWriteAvailable ();
+uint32_t   w		= writeIndex. load (std::memory_order_relaxed);
+uint32_t   available	= bufferSize - clamp (w - cachedReadIndex);
+
+	if (available < elementCount) {
+	   cachedReadIndex = readIndex. load (std::memory_order_acquire);
+	   available	= bufferSize - clamp (w - cachedReadIndex);
+	}
 
 	if (elementCount > available)
 	   elementCount = available;
 
 /* Check to see if write is not contiguous. */
-	index = writeIndex & smallMask;
-	if ((index + elementCount) > bufferSize ) {
+	index = w & smallMask;
+	if (!mirrored && ((index + elementCount) > bufferSize)) {
         /* Write data in two blocks that wrap the buffer. */
            int32_t   firstHalf = bufferSize - index;
            *dataPtr1	= &buffer[index * sizeof(elementtype)];
@@ -229,9 +237,6 @@ uint32_t   available = GetRingBufferWriteAvailable ();
 	   *sizePtr2	= 0;
 	}
 
-	if (available > 0)
-           PaUtil_FullMemoryBarrier(); /* (write-after-read) => full barrier */
-
 	return elementCount;
 }
 
@@ -240,19 +245,26 @@ uint32_t   available = GetRingBufferWriteAvailable ();
 ** If the region is contiguous, size2 will be zero.
 ** If non-contiguous, size2 will be the size of second region.
 ** Returns room available to be read or elementCount, whichever is smaller.
+** Only to be called by the reader.
 */
 int32_t GetRingBufferReadRegions (uint32_t elementCount,
 	                          void **dataPtr1, int32_t *sizePtr1,
 	                          void **dataPtr2, int32_t *sizePtr2) {
 uint32_t   index;
-uint32_t   available = GetRingBufferReadAvailable (); /* doesn't use memory barrier */
+uint32_t   r		= readIndex. load (std::memory_order_relaxed);
+uint32_t   available	= clamp (cachedWriteIndex - r);
+
+	if (available < elementCount) {
+	   cachedWriteIndex = writeIndex. load (std::memory_order_acquire);
+	   available	= clamp (cachedWriteIndex - r);
+	}
 
 	if (elementCount > available)
 	   elementCount = available;
 
 /* Check to see if read is not contiguous. */
-	index = readIndex & smallMask;
-	if ((index + elementCount) > bufferSize) {
+	index = r & smallMask;
+	if (!mirrored && ((index + elementCount) > bufferSize)) {
         /* Write data in two blocks that wrap the buffer. */
            int32_t firstHalf = bufferSize - index;
 	   *dataPtr1 = &buffer [index * sizeof(elementtype)];
@@ -267,9 +279,6 @@ uint32_t   available = GetRingBufferReadAvailable (); /* doesn't use memory barr
 	   *sizePtr2 = 0;
 	}
     
-	if (available)
-           PaUtil_ReadMemoryBarrier(); /* (read-after-read) => read barrier */
-
 	return elementCount;
 }
 
@@ -314,8 +323,6 @@ void	*data2;
 }
 
 int32_t	skipDataInBuffer (uint32_t n_values) {
-//	ensure that we have the correct read and write indices
-	PaUtil_FullMemoryBarrier ();
 	if (n_values > GetRingBufferReadAvailable ())
 	   n_values = GetRingBufferReadAvailable ();
 	AdvanceRingBufferReadIndex (n_values);
@@ -0,0 +1,217 @@
+#
+/*
+ *    Copyright (C) 2025
+ *    Jan van Katwijk (J.vanKatwijk@gmail.com)
+ *    Lazy Chair Computing
+ *
+ *    This file is part of sdrplay_tcp
+ *
+ *    sdrplay_tcp is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    sdrplay_tcp is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with sdrplay_tcp; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include	"sample-formats.h"
+#include	"simd-kernels.h"
+#include	<string.h>
+
+int	samplesPerGroup	(int format, int nrBits) {
+int	n	= 1;
+	if (format != FORMAT_PACKED)
+	   return 1;
+	while ((2 * nrBits * n) % 8 != 0)
+	   n ++;
+	return n;
+}
+
+int	bytesPerGroup	(int format, int nrBits) {
+	switch (format) {
+	   case FORMAT_CU8:
+	   case FORMAT_CS8:
+	      return 2;
+	   case FORMAT_CS16:
+	   case FORMAT_COMPRESSED:		// not used, cs16 in
+	      return 4;
+	   case FORMAT_CF32:
+	      return 8;
+	   case FORMAT_PACKED:
+	      return 2 * nrBits * samplesPerGroup (format, nrBits) / 8;
+	   default:
+	      return 2;
+	}
+}
+
+bool	validFormat	(int format) {
+	return (format >= 0) && (format < NR_FORMATS);
+}
+
+static inline
+void	put_32	(uint8_t *b, uint32_t v) {
+	b [0]	= (v >> 24) & 0xFF;
+	b [1]	= (v >> 16) & 0xFF;
+	b [2]	= (v >>  8) & 0xFF;
+	b [3]	= v & 0xFF;
+}
+//
+//	The header, 16 bytes, telling the format of what follows
+//	"SFMT", format, nrBits, 2 bytes 0, samplerate (big endian), 4 bytes 0
+int	formatHeader	(uint8_t *b, int format, int nrBits, int sampleRate) {
+	memset (b, 0, FORMAT_HEADER_SIZE);
+	b [0]	= 'S';
+	b [1]	= 'F';
+	b [2]	= 'M';
+	b [3]	= 'T';
+	b [4]	= format;
+	b [5]	= nrBits;
+	put_32 (&b [8], sampleRate);
+	return FORMAT_HEADER_SIZE;
+}
+
+static inline
+int16_t	clamp_8	(int v) {
+	return v < -128 ? -128 : v > 127 ? 127 : v;
+}
+static inline
+int16_t	clamp_16	(int v) {
+	return v < -32768 ? -32768 : v > 32767 ? 32767 : v;
+}
+//
+//	The packed format is a little endian bit stream of nrBits
+//	two's complement values, I first. 12 and 14 bits, the ones the
+//	RSP's deliver, have their own loops, 3 bytes per I/Q pair
+//	resp. 7 bytes per two pairs
+static inline
+int	clamp_n	(int v, int nrBits) {
+int	max	= (1 << (nrBits - 1)) - 1;
+	return v < -max - 1 ? -max - 1 : v > max ? max : v;
+}
+
+static
+void	pack_12	(const int16_t *v, int n, uint8_t *out) {
+	for (int i = 0; i < n; i += 2) {
+	   uint32_t w	= (clamp_n (v [i], 12) & 0xFFF) |
+	                  ((clamp_n (v [i + 1], 12) & 0xFFF) << 12);
+	   out [0]	= w & 0xFF;
+	   out [1]	= (w >> 8) & 0xFF;
+	   out [2]	= (w >> 16) & 0xFF;
+	   out	+= 3;
+	}
+}
+
+static
+void	pack_14	(const int16_t *v, int n, uint8_t *out) {
+	for (int i = 0; i < n; i += 4) {
+	   uint64_t w	= ((uint64_t)(clamp_n (v [i], 14) & 0x3FFF)) |
+	                  ((uint64_t)(clamp_n (v [i + 1], 14) & 0x3FFF) << 14) |
+	                  ((uint64_t)(clamp_n (v [i + 2], 14) & 0x3FFF) << 28) |
+	                  ((uint64_t)(clamp_n (v [i + 3], 14) & 0x3FFF) << 42);
+	   for (int j = 0; j < 7; j ++)
+	      out [j] = (w >> (8 * j)) & 0xFF;
+	   out	+= 7;
+	}
+}
+
+static
+void	packSamples	(const int16_t *v, int n,
+	                         uint8_t *out, int nrBits) {
+uint64_t acc	= 0;
+int	inAcc	= 0;
+uint32_t mask	= (1 << nrBits) - 1;
+	if (nrBits == 12) {
+	   pack_12 (v, n, out);
+	   return;
+	}
+	if (nrBits == 14) {
+	   pack_14 (v, n, out);
+	   return;
+	}
+	for (int i = 0; i < n; i ++) {
+	   acc	|= (uint64_t)(clamp_n (v [i], nrBits) & mask) << inAcc;
+	   inAcc	+= nrBits;
+	   while (inAcc >= 8) {
+	      *out ++	= acc & 0xFF;
+	      acc	>>= 8;
+	      inAcc	-= 8;
+	   }
+	}
+}
+
+int	unpackSamples	(const uint8_t *in, int n,
+	                         std::complex<int16_t> *out, int nrBits) {
+int16_t	*v	= (int16_t *)out;
+uint64_t acc	= 0;
+int	inAcc	= 0;
+int	used	= 0;
+uint32_t mask	= (1 << nrBits) - 1;
+	for (int i = 0; i < 2 * n; i ++) {
+	   while (inAcc < nrBits) {
+	      acc	|= (uint64_t)(in [used ++]) << inAcc;
+	      inAcc	+= 8;
+	   }
+	   int32_t x	= acc & mask;
+	   if (x & (1 << (nrBits - 1)))		// sign extend
+	      x -= 1 << nrBits;
+	   v [i]	= x;
+	   acc	>>= nrBits;
+	   inAcc	-= nrBits;
+	}
+	return used;
+}
+
+//
+//	The samples are interleaved I/Q int16 values, so we just
+//	convert 2 * n values. The bulk is done by the vector kernels,
+//	the loops here do the remainder (and everything on machines
+//	without them).
+//	As the conversion to cu8 always did, we take 2^nrBits as
+//	full scale, so existing cu8 clients see the same levels
+void	convertSamples	(const std::complex<int16_t> *in, int n,
+	                         uint8_t *out, int format, int nrBits) {
+const int16_t	*v	= (const int16_t *)in;
+int	done	= convertValues_simd (v, 2 * n, out, format, nrBits);
+	switch (format) {
+	   case FORMAT_CU8: {
+	      int shift	= nrBits - 7;
+	      for (int i = done; i < 2 * n; i ++)
+	         out [i] = (uint8_t)(clamp_8 (v [i] >> shift) + 128);
+	      break;
+	   }
+	   case FORMAT_CS8: {
+	      int shift	= nrBits - 7;
+	      int8_t *o	= (int8_t *)out;
+	      for (int i = done; i < 2 * n; i ++)
+	         o [i] = (int8_t)clamp_8 (v [i] >> shift);
+	      break;
+	   }
+	   case FORMAT_CS16: {
+	      int shift	= 15 - nrBits;
+	      int16_t *o = (int16_t *)out;
+	      for (int i = done; i < 2 * n; i ++)
+	         o [i] = clamp_16 (v [i] * (1 << shift));
+	      break;
+	   }
+	   case FORMAT_CF32: {		// -1 .. 1
+	      float scale	= 1.0f / (1 << nrBits);
+	      float *o	= (float *)out;
+	      for (int i = done; i < 2 * n; i ++)
+	         o [i] = v [i] * scale;
+	      break;
+	   }
+	   case FORMAT_PACKED:
+	      packSamples (v, 2 * n, out, nrBits);
+	      break;
+	   default:		// the compressed format is not done here
+	      break;
+	}
+}
+
@@ -0,0 +1,68 @@
+#
+/*
+ *    Copyright (C) 2025
+ *    Jan van Katwijk (J.vanKatwijk@gmail.com)
+ *    Lazy Chair Computing
+ *
+ *    This file is part of sdrplay_tcp
+ *
+ *    sdrplay_tcp is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    sdrplay_tcp is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with sdrplay_tcp; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#pragma once
+
+#include	<stdint.h>
+#include	<complex>
+
+//
+//	The formats in which the samples can be sent to a client.
+//	The device delivers nrBits (12 or 14) bits signed samples,
+//	cu8 is what rtl_tcp clients expect and the default
+enum	sampleFormat {
+	FORMAT_CU8	= 0,
+	FORMAT_CS8	= 1,
+	FORMAT_CS16	= 2,
+	FORMAT_CF32	= 3,
+	FORMAT_PACKED	= 4,		// nrBits I and Q, bit packed
+	FORMAT_COMPRESSED = 5,		// frames, see rice-coder.h
+	NR_FORMATS
+};
+
+//	when a client switches format, the new data is preceded
+//	by a header of this size
+#define	FORMAT_HEADER_SIZE	16
+
+//
+//	Data is handled in groups, the smallest number of samples
+//	that fills a whole number of bytes. Only for the packed format
+//	a group may contain more than one sample, e.g. with 14 bits
+//	2 samples take 7 bytes.
+int	samplesPerGroup		(int format, int nrBits);
+int	bytesPerGroup		(int format, int nrBits);
+bool	validFormat		(int format);
+int	formatHeader		(uint8_t *, int format,
+	                                    int nrBits, int sampleRate);
+//
+//	bulk conversion from the nrBits samples to the wire format,
+//	n should be a multiple of samplesPerGroup, "out" should provide
+//	room for n / samplesPerGroup * bytesPerGroup bytes
+void	convertSamples		(const std::complex<int16_t> *in, int n,
+	                         uint8_t *out, int format, int nrBits);
+//
+//	the reverse of the packing, for use by clients, returns the
+//	number of bytes used
+int	unpackSamples		(const uint8_t *in, int n,
+	                         std::complex<int16_t> *out, int nrBits);
+
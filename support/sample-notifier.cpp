@@ -0,0 +1,79 @@
+#
+/*
+ *    Copyright (C) 2025
+ *    Jan van Katwijk (J.vanKatwijk@gmail.com)
+ *    Lazy Chair Computing
+ *
+ *    This file is part of sdrplay_tcp
+ *
+ *    sdrplay_tcp is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    sdrplay_tcp is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with sdrplay_tcp; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include	"sample-notifier.h"
+#ifdef	__linux__
+#include	<sys/eventfd.h>
+#include	<poll.h>
+#include	<unistd.h>
+#include	<stdint.h>
+#endif
+
+	sampleNotifier::sampleNotifier	() {
+	pending. store (false);
+#ifdef	__linux__
+	eventFd	= eventfd (0, EFD_NONBLOCK | EFD_CLOEXEC);
+#endif
+}
+
+	sampleNotifier::~sampleNotifier	() {
+#ifdef	__linux__
+	if (eventFd >= 0)
+	   close (eventFd);
+#endif
+}
+//
+//	called from the producer's thread, when the consumer is
+//	already signalled there is nothing to do
+void	sampleNotifier::notify	() {
+	if (pending. exchange (true))
+	   return;
+#ifdef	__linux__
+uint64_t one	= 1;
+	if (write (eventFd, &one, sizeof (one)) < 0)
+	   pending. store (false);
+#else
+	wakeups. release (1);
+#endif
+}
+//
+//	returns true if we were signalled, false on a timeout
+bool	sampleNotifier::wait	(int timeout_ms) {
+#ifdef	__linux__
+struct pollfd	pfd;
+uint64_t	counter;
+	pfd. fd		= eventFd;
+	pfd. events	= POLLIN;
+	pfd. revents	= 0;
+	if (poll (&pfd, 1, timeout_ms) <= 0)
+	   return false;
+	if (read (eventFd, &counter, sizeof (counter)) < 0)
+	   return false;
+#else
+	if (!wakeups. tryAcquire (1, timeout_ms))
+	   return false;
+#endif
+	pending. store (false);
+	return true;
+}
+
@@ -0,0 +1,51 @@
+#
+/*
+ *    Copyright (C) 2025
+ *    Jan van Katwijk (J.vanKatwijk@gmail.com)
+ *    Lazy Chair Computing
+ *
+ *    This file is part of sdrplay_tcp
+ *
+ *    sdrplay_tcp is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    sdrplay_tcp is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with sdrplay_tcp; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#pragma once
+
+#include	<atomic>
+#ifndef	__linux__
+#include	<QSemaphore>
+#endif
+
+//
+//	A lightweight wakeup for the thread consuming the samples.
+//	The producer (the device callback) calls "notify", which only
+//	costs a system call if the consumer is not already signalled,
+//	the consumer "waits" with a timeout.
+//	On Linux an eventfd is used, elsewhere a semaphore.
+class	sampleNotifier {
+public:
+		sampleNotifier	();
+		~sampleNotifier	();
+	void	notify		();
+	bool	wait		(int timeout_ms);
+private:
+	std::atomic<bool>	pending;
+#ifdef	__linux__
+	int		eventFd;
+#else
+	QSemaphore	wakeups;
+#endif
+};
+
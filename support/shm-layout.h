@@ -0,0 +1,65 @@
+#
+/*
+ *    Copyright (C) 2025
+ *    Jan van Katwijk (J.vanKatwijk@gmail.com)
+ *    Lazy Chair Computing
+ *
+ *    This file is part of sdrplay_tcp
+ *
+ *    sdrplay_tcp is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    sdrplay_tcp is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with sdrplay_tcp; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#pragma once
+
+#include	<stdint.h>
+#include	<atomic>
+
+//
+//	The layout of the shared memory segment the server publishes
+//	the samples in, shared by the server (shmHandler) and the
+//	readers (shm-client).
+//	The segment is a header of SHM_HEADER_SIZE bytes, followed by
+//	"capacity" (a power of 2) int16 I/Q samples, as delivered by
+//	the device (nrBits bits).
+//	writeSeq counts the samples written since the start, sample s
+//	lives in slot s % capacity. The writer writes at most maxChunk
+//	samples before it updates writeSeq, so a reader that stays
+//	within capacity - maxChunk samples of writeSeq reads valid data.
+//	After each update futexWord is incremented. A reader that is
+//	going to wait on futexWord increments waiters first (and
+//	decrements it when it wakes up), the writer only makes the
+//	FUTEX_WAKE call when waiters is not zero. Readers therefore
+//	need write access to the header.
+#define	SHM_MAGIC	"SDRPSHM1"
+#define	SHM_VERSION	2
+#define	SHM_HEADER_SIZE	4096
+
+struct	shmHeader {
+	char		magic [8];
+	uint32_t	version;
+	uint32_t	headerSize;
+	uint32_t	capacity;
+	uint32_t	maxChunk;
+	std::atomic<uint32_t>	nrBits;
+	std::atomic<uint32_t>	sampleRate;
+	alignas (64) std::atomic<uint64_t>	writeSeq;
+	alignas (64) std::atomic<uint32_t>	futexWord;
+	std::atomic<uint32_t>	waiters;
+};
+
+static_assert (std::atomic<uint64_t>::is_always_lock_free,
+	        "the shared memory transport needs lock free 64 bit atomics");
+static_assert (sizeof (shmHeader) <= SHM_HEADER_SIZE, "header too large");
+
@@ -0,0 +1,314 @@
+#
+/*
+ *    Copyright (C) 2025
+ *    Jan van Katwijk (J.vanKatwijk@gmail.com)
+ *    Lazy Chair Computing
+ *
+ *    This file is part of sdrplay_tcp
+ *
+ *    sdrplay_tcp is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    sdrplay_tcp is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with sdrplay_tcp; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include	"simd-kernels.h"
+#include	"sample-formats.h"
+
+#if (defined (__x86_64__) || defined (__i386__)) && defined (__GNUC__)
+#define	HAVE_X86_KERNELS
+#include	<immintrin.h>
+#endif
+
+static
+void	interleave_plain	(const int16_t *xi, const int16_t *xq,
+	                         int n, std::complex<int16_t> *out) {
+	for (int i = 0; i < n; i ++)
+	   out [i] = std::complex<int16_t> (xi [i], xq [i]);
+}
+
+static
+int	convert_plain	(const int16_t *v, int m, uint8_t *out,
+	                         int format, int nrBits) {
+	(void)v; (void)m; (void)out; (void)format; (void)nrBits;
+	return 0;
+}
+
+static
+void	dot_plain	(const float *c, const float *re, const float *im,
+	                 int n, float &outRe, float &outIm) {
+float	sumRe	= 0;
+float	sumIm	= 0;
+	for (int i = 0; i < n; i ++) {
+	   sumRe	+= c [i] * re [i];
+	   sumIm	+= c [i] * im [i];
+	}
+	outRe	= sumRe;
+	outIm	= sumIm;
+}
+
+#ifdef	HAVE_X86_KERNELS
+//
+//	SSE2, 8 values per step
+__attribute__ ((target ("sse2")))
+static
+void	interleave_sse2	(const int16_t *xi, const int16_t *xq,
+	                         int n, std::complex<int16_t> *out) {
+int	i	= 0;
+int16_t	*o	= (int16_t *)out;
+	for (; i + 8 <= n; i += 8) {
+	   __m128i a	= _mm_loadu_si128 ((const __m128i *)(xi + i));
+	   __m128i b	= _mm_loadu_si128 ((const __m128i *)(xq + i));
+	   _mm_storeu_si128 ((__m128i *)(o + 2 * i),
+	                               _mm_unpacklo_epi16 (a, b));
+	   _mm_storeu_si128 ((__m128i *)(o + 2 * i + 8),
+	                               _mm_unpackhi_epi16 (a, b));
+	}
+	interleave_plain (xi + i, xq + i, n - i, out + i);
+}
+
+__attribute__ ((target ("sse2")))
+static
+int	convert_sse2	(const int16_t *v, int m, uint8_t *out,
+	                         int format, int nrBits) {
+int	i	= 0;
+	switch (format) {
+	   case FORMAT_CU8:
+	   case FORMAT_CS8: {
+	      __m128i shift	= _mm_cvtsi32_si128 (nrBits - 7);
+	      __m128i offset	= _mm_set1_epi8 (format == FORMAT_CU8 ?
+	                                               (char)0x80 : 0);
+	      for (; i + 16 <= m; i += 16) {
+	         __m128i a = _mm_sra_epi16 (
+	                     _mm_loadu_si128 ((const __m128i *)(v + i)), shift);
+	         __m128i b = _mm_sra_epi16 (
+	                     _mm_loadu_si128 ((const __m128i *)(v + i + 8)), shift);
+	         _mm_storeu_si128 ((__m128i *)(out + i),
+	                     _mm_xor_si128 (_mm_packs_epi16 (a, b), offset));
+	      }
+	      return i;
+	   }
+	   case FORMAT_CS16: {
+	      __m128i shift	= _mm_cvtsi32_si128 (15 - nrBits);
+	      int16_t *o	= (int16_t *)out;
+	      for (; i + 8 <= m; i += 8) {
+	         __m128i a = _mm_loadu_si128 ((const __m128i *)(v + i));
+	         __m128i lo = _mm_srai_epi32 (_mm_unpacklo_epi16 (a, a), 16);
+	         __m128i hi = _mm_srai_epi32 (_mm_unpackhi_epi16 (a, a), 16);
+	         _mm_storeu_si128 ((__m128i *)(o + i),
+	                     _mm_packs_epi32 (_mm_sll_epi32 (lo, shift),
+	                                      _mm_sll_epi32 (hi, shift)));
+	      }
+	      return i;
+	   }
+	   case FORMAT_CF32: {
+	      __m128 scale	= _mm_set1_ps (1.0f / (1 << nrBits));
+	      float *o	= (float *)out;
+	      for (; i + 8 <= m; i += 8) {
+	         __m128i a = _mm_loadu_si128 ((const __m128i *)(v + i));
+	         __m128i lo = _mm_srai_epi32 (_mm_unpacklo_epi16 (a, a), 16);
+	         __m128i hi = _mm_srai_epi32 (_mm_unpackhi_epi16 (a, a), 16);
+	         _mm_storeu_ps (o + i, _mm_mul_ps (_mm_cvtepi32_ps (lo), scale));
+	         _mm_storeu_ps (o + i + 4,
+	                             _mm_mul_ps (_mm_cvtepi32_ps (hi), scale));
+	      }
+	      return i;
+	   }
+	   default:
+	      return 0;
+	}
+}
+__attribute__ ((target ("sse2")))
+static
+void	dot_sse2	(const float *c, const float *re, const float *im,
+	                 int n, float &outRe, float &outIm) {
+__m128	accRe	= _mm_setzero_ps ();
+__m128	accIm	= _mm_setzero_ps ();
+float	r [4], q [4];
+int	i	= 0;
+	for (; i + 4 <= n; i += 4) {
+	   __m128 cc	= _mm_loadu_ps (c + i);
+	   accRe	= _mm_add_ps (accRe, _mm_mul_ps (cc, _mm_loadu_ps (re + i)));
+	   accIm	= _mm_add_ps (accIm, _mm_mul_ps (cc, _mm_loadu_ps (im + i)));
+	}
+	_mm_storeu_ps (r, accRe);
+	_mm_storeu_ps (q, accIm);
+	outRe	= r [0] + r [1] + r [2] + r [3];
+	outIm	= q [0] + q [1] + q [2] + q [3];
+	for (; i < n; i ++) {
+	   outRe	+= c [i] * re [i];
+	   outIm	+= c [i] * im [i];
+	}
+}
+//
+//	AVX2, 16 values per step. The pack instructions work per 128 bit
+//	lane, a permute puts the 64 bit quarters back in order
+__attribute__ ((target ("avx2")))
+static
+void	interleave_avx2	(const int16_t *xi, const int16_t *xq,
+	                         int n, std::complex<int16_t> *out) {
+int	i	= 0;
+int16_t	*o	= (int16_t *)out;
+	for (; i + 16 <= n; i += 16) {
+	   __m256i a	= _mm256_loadu_si256 ((const __m256i *)(xi + i));
+	   __m256i b	= _mm256_loadu_si256 ((const __m256i *)(xq + i));
+	   __m256i lo	= _mm256_unpacklo_epi16 (a, b);
+	   __m256i hi	= _mm256_unpackhi_epi16 (a, b);
+	   _mm256_storeu_si256 ((__m256i *)(o + 2 * i),
+	                        _mm256_permute2x128_si256 (lo, hi, 0x20));
+	   _mm256_storeu_si256 ((__m256i *)(o + 2 * i + 16),
+	                        _mm256_permute2x128_si256 (lo, hi, 0x31));
+	}
+	interleave_sse2 (xi + i, xq + i, n - i, out + i);
+}
+
+__attribute__ ((target ("avx2")))
+static
+int	convert_avx2	(const int16_t *v, int m, uint8_t *out,
+	                         int format, int nrBits) {
+int	i	= 0;
+	switch (format) {
+	   case FORMAT_CU8:
+	   case FORMAT_CS8: {
+	      __m128i shift	= _mm_cvtsi32_si128 (nrBits - 7);
+	      __m256i offset	= _mm256_set1_epi8 (format == FORMAT_CU8 ?
+	                                                  (char)0x80 : 0);
+	      for (; i + 32 <= m; i += 32) {
+	         __m256i a = _mm256_sra_epi16 (
+	                 _mm256_loadu_si256 ((const __m256i *)(v + i)), shift);
+	         __m256i b = _mm256_sra_epi16 (
+	                 _mm256_loadu_si256 ((const __m256i *)(v + i + 16)), shift);
+	         __m256i p = _mm256_permute4x64_epi64 (
+	                             _mm256_packs_epi16 (a, b), 0xD8);
+	         _mm256_storeu_si256 ((__m256i *)(out + i),
+	                             _mm256_xor_si256 (p, offset));
+	      }
+	      break;
+	   }
+	   case FORMAT_CS16: {
+	      __m128i shift	= _mm_cvtsi32_si128 (15 - nrBits);
+	      int16_t *o	= (int16_t *)out;
+	      for (; i + 16 <= m; i += 16) {
+	         __m256i lo = _mm256_cvtepi16_epi32 (
+	                         _mm_loadu_si128 ((const __m128i *)(v + i)));
+	         __m256i hi = _mm256_cvtepi16_epi32 (
+	                         _mm_loadu_si128 ((const __m128i *)(v + i + 8)));
+	         __m256i p  = _mm256_packs_epi32 (_mm256_sll_epi32 (lo, shift),
+	                                          _mm256_sll_epi32 (hi, shift));
+	         _mm256_storeu_si256 ((__m256i *)(o + i),
+	                             _mm256_permute4x64_epi64 (p, 0xD8));
+	      }
+	      break;
+	   }
+	   case FORMAT_CF32: {
+	      __m256 scale	= _mm256_set1_ps (1.0f / (1 << nrBits));
+	      float *o	= (float *)out;
+	      for (; i + 8 <= m; i += 8) {
+	         __m256i a = _mm256_cvtepi16_epi32 (
+	                         _mm_loadu_si128 ((const __m128i *)(v + i)));
+	         _mm256_storeu_ps (o + i,
+	                     _mm256_mul_ps (_mm256_cvtepi32_ps (a), scale));
+	      }
+	      break;
+	   }
+	   default:
+	      return 0;
+	}
+	return i;
+}
+//
+//	with FMA, which all AVX2 machines have
+__attribute__ ((target ("avx2,fma")))
+static
+void	dot_avx2	(const float *c, const float *re, const float *im,
+	                 int n, float &outRe, float &outIm) {
+__m256	accRe	= _mm256_setzero_ps ();
+__m256	accIm	= _mm256_setzero_ps ();
+float	r [8], q [8];
+int	i	= 0;
+	for (; i + 8 <= n; i += 8) {
+	   __m256 cc	= _mm256_loadu_ps (c + i);
+	   accRe	= _mm256_fmadd_ps (cc, _mm256_loadu_ps (re + i), accRe);
+	   accIm	= _mm256_fmadd_ps (cc, _mm256_loadu_ps (im + i), accIm);
+	}
+	_mm256_storeu_ps (r, accRe);
+	_mm256_storeu_ps (q, accIm);
+	outRe	= 0;
+	outIm	= 0;
+	for (int j = 0; j < 8; j ++) {
+	   outRe	+= r [j];
+	   outIm	+= q [j];
+	}
+	for (; i < n; i ++) {
+	   outRe	+= c [i] * re [i];
+	   outIm	+= c [i] * im [i];
+	}
+}
+#endif
+
+typedef void (*interleaver) (const int16_t *, const int16_t *,
+	                                 int, std::complex<int16_t> *);
+typedef int (*converter) (const int16_t *, int, uint8_t *, int, int);
+typedef void (*dotter) (const float *, const float *, const float *,
+	                                 int, float &, float &);
+
+struct kernels {
+	interleaver	interleave;
+	converter	convert;
+	dotter		dot;
+	const char	*name;
+};
+static
+kernels	findKernels	() {
+kernels	res	= {interleave_plain, convert_plain, dot_plain, "none"};
+#ifdef	HAVE_X86_KERNELS
+	__builtin_cpu_init ();
+	if (__builtin_cpu_supports ("avx2") && __builtin_cpu_supports ("fma"))
+	   res	= {interleave_avx2, convert_avx2, dot_avx2, "avx2"};
+	else
+	if (__builtin_cpu_supports ("sse2"))
+	   res	= {interleave_sse2, convert_sse2, dot_sse2, "sse2"};
+#endif
+	return res;
+}
+//
+//	chosen once, on first use
+static
+const kernels	&selectKernels	() {
+static	kernels	k	= findKernels ();
+	return k;
+}
+
+void	interleaveSamples	(const int16_t *xi, const int16_t *xq,
+	                         int n, std::complex<int16_t> *out) {
+	selectKernels (). interleave (xi, xq, n, out);
+}
+//
+//	the shifts are only valid for the bit depths of the devices,
+//	for others the plain loops do the job
+int	convertValues_simd	(const int16_t *v, int m, uint8_t *out,
+	                         int format, int nrBits) {
+	if ((nrBits < 8) || (nrBits > 15))
+	   return 0;
+	return selectKernels (). convert (v, m, out, format, nrBits);
+}
+
+void	dotProduct2	(const float *c, const float *re,
+	                 const float *im, int n,
+	                 float &outRe, float &outIm) {
+	selectKernels (). dot (c, re, im, n, outRe, outIm);
+}
+
+const char	*simdLevel	() {
+	return selectKernels (). name;
+}
+
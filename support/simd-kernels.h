@@ -0,0 +1,53 @@
+#
+/*
+ *    Copyright (C) 2025
+ *    Jan van Katwijk (J.vanKatwijk@gmail.com)
+ *    Lazy Chair Computing
+ *
+ *    This file is part of sdrplay_tcp
+ *
+ *    sdrplay_tcp is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    sdrplay_tcp is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with sdrplay_tcp; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#pragma once
+
+#include	<stdint.h>
+#include	<complex>
+
+//
+//	Vectorized versions of the inner loops on the sample path.
+//	On x86 the best of AVX2 and SSE2 is chosen at run time, on other
+//	machines (or with other compilers) the plain loops are used.
+//
+//	planar I and Q, as the sdrplay library delivers them, to
+//	interleaved I/Q pairs
+void	interleaveSamples	(const int16_t *xi, const int16_t *xq,
+	                         int n, std::complex<int16_t> *out);
+//
+//	converts m int16 values, shifted by nrBits, to cu8, cs8, cs16
+//	or cf32, as convertSamples does. Returns the number of values
+//	handled (a multiple of the vector width), the caller does the rest
+int	convertValues_simd	(const int16_t *v, int m, uint8_t *out,
+	                         int format, int nrBits);
+//
+//	the inner loop of the FIR filters, for I and Q at once: the
+//	sum of c [i] * re [i] and of c [i] * im [i], i = 0 .. n - 1
+void	dotProduct2		(const float *c, const float *re,
+	                         const float *im, int n,
+	                         float &outRe, float &outIm);
+//
+//	"avx2", "sse2" or "none", for the log
+const char	*simdLevel	();
+
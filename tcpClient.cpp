@@ -0,0 +1,405 @@
+#
+/*
+ *    Copyright (C)  2025
+ *    Jan van Katwijk (J.vanKatwijk@gmail.com)
+ *    Lazy Chair Computing
+ *
+ *    This file is part of the sdrplayServer
+ *
+ *    sdrplayServer is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    sdrplayServer is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with sdrplayServer; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include	"tcpClient.h"
+#include	"ddc-channel.h"
+#include	<string.h>
+#include	<stdio.h>
+#ifdef	__MINGW32__
+#include	<winsock2.h>
+#else
+#include	<sys/types.h>
+#include	<sys/socket.h>
+#include	<sys/uio.h>
+#include	<netinet/in.h>
+#include	<netinet/tcp.h>
+#include	<errno.h>
+#endif
+
+	tcpClient::tcpClient	(QTcpSocket *theSocket,
+	                         int clientId, int bufferSize, int policy):
+	                            outBuffer (bufferSize) {
+	this	-> theSocket	= theSocket;
+	this	-> id		= clientId;
+	this	-> policy. store (policy);
+	mustDisconnect. store (false);
+	nrBytesSent. store (0);
+	nrSamplesDropped. store (0);
+	nrOverflows. store (0);
+	coalesceBytes. store (0);
+	latency_ms. store (0);
+	requestedFormat. store (FORMAT_CU8);
+	requestedOffset. store (0);
+	requestedRate. store (0);
+	reconfigure. store (false);
+	channel		= nullptr;
+	channelInput	= 0;
+	requestedSubband. store (NO_SUBBAND);
+	theSubband	= NO_SUBBAND;
+	subbandInput	= 0;
+	format		= FORMAT_CU8;
+	groupSamples	= 1;
+	groupBytes	= 2;
+	headerBytes	= 0;
+	dataPending	= false;
+}
+
+	tcpClient::~tcpClient	() {
+	delete channel;
+}
+
+QTcpSocket	*tcpClient::socket	() {
+	return theSocket;
+}
+
+int	tcpClient::clientId	() {
+	return id;
+}
+
+uint64_t	tcpClient::bytesSent	() {
+	return nrBytesSent. load ();
+}
+
+uint64_t	tcpClient::samplesDropped	() {
+	return nrSamplesDropped. load ();
+}
+
+uint64_t	tcpClient::overflows	() {
+	return nrOverflows. load ();
+}
+//
+//	fill degree of the buffer in percents
+int	tcpClient::bufferFill	() {
+	return 100 - 100 * outBuffer. GetRingBufferWriteAvailable () /
+	                                   (outBuffer. GetRingBufferWriteAvailable () +
+	                                    outBuffer. GetRingBufferReadAvailable ());
+}
+
+void	tcpClient::setPolicy	(int policy) {
+	this	-> policy. store (policy);
+}
+
+//
+//	data is only sent when at least "bytes" are waiting, or when
+//	the oldest data waited for latency_ms
+void	tcpClient::setCoalescing	(int bytes, int latency_ms) {
+	coalesceBytes. store (bytes);
+	this	-> latency_ms. store (latency_ms);
+}
+
+void	tcpClient::setSocketOptions	(bool noDelay, bool cork,
+	                                 int sendBuffer) {
+int	fd	= theSocket -> socketDescriptor ();
+int	flag;
+	if (fd < 0)
+	   return;
+	flag	= noDelay ? 1 : 0;
+	setsockopt (fd, IPPROTO_TCP, TCP_NODELAY, (char *)&flag, sizeof (flag));
+#ifdef	TCP_CORK
+	flag	= cork ? 1 : 0;
+	setsockopt (fd, IPPROTO_TCP, TCP_CORK, (char *)&flag, sizeof (flag));
+#else
+	(void)cork;
+#endif
+	if (sendBuffer > 0)
+	   setsockopt (fd, SOL_SOCKET, SO_SNDBUF,
+	                        (char *)&sendBuffer, sizeof (sendBuffer));
+}
+
+bool	tcpClient::disconnectRequested	() {
+	return mustDisconnect. load ();
+}
+//
+//	A format change (or a channel change), asked for by the client,
+//	is handled by the streamer's thread. Since a client has to be
+//	able to tell where the new format starts, we wait until
+//	everything in the old format is sent, samples arriving in the
+//	mean time are dropped. The new data is then preceded by a header
+//	telling the format and the rate.
+void	tcpClient::requestFormat	(int format) {
+	requestedFormat. store (format);
+	reconfigure. store (true);
+}
+
+void	tcpClient::setChannelOffset	(int offset) {
+	requestedOffset. store (offset);
+	reconfigure. store (true);
+}
+//
+//	rate 0 means: the full band
+void	tcpClient::setChannelRate	(int rate) {
+	requestedRate. store (rate);
+	reconfigure. store (true);
+}
+
+//
+//	a channel of the filter bank
+void	tcpClient::setSubband	(int subband) {
+	requestedSubband. store (subband);
+	reconfigure. store (true);
+}
+
+int	tcpClient::subband	() {
+	return theSubband;
+}
+
+//
+//	A return value of -1 means "not now, drop the samples"
+int	tcpClient::activeFormat	(int nrBits, int sampleRate,
+	                                         int subbandRate) {
+uint8_t	header [FORMAT_HEADER_SIZE];
+int	rate	= sampleRate;
+bool	rateChanged	= ((channel != nullptr) &&
+	                           (channelInput != sampleRate)) ||
+	                  ((theSubband != NO_SUBBAND) &&
+	                           (subbandInput != sampleRate));
+	if (!reconfigure. load () && !rateChanged)
+	   return format;
+	if (outBuffer. GetRingBufferReadAvailable () > 0)
+	   return -1;
+	reconfigure. store (false);
+	format		= requestedFormat. load ();
+	groupSamples	= samplesPerGroup (format, nrBits);
+	groupBytes	= bytesPerGroup (format, nrBits);
+	delete channel;
+	channel		= nullptr;
+	carry. resize (0);
+	theSubband	= format == FORMAT_COMPRESSED ?
+	                      NO_SUBBAND : requestedSubband. load ();
+	int wanted	= requestedRate. load ();
+	if (theSubband != NO_SUBBAND) {
+	   subbandInput	= sampleRate;
+	   rate		= subbandRate;
+	}
+	else
+	if ((wanted > 0) && (wanted < sampleRate) &&
+	                          (format != FORMAT_COMPRESSED)) {
+	   channel	= new ddcChannel (sampleRate,
+	                                  requestedOffset. load (), wanted);
+	   channel	-> setGranularity (groupSamples);
+	   channelInput	= sampleRate;
+	   rate		= channel -> outRate ();
+	}
+	formatHeader (header, format, nrBits, rate);
+	outBuffer. putDataIntoBuffer (header, FORMAT_HEADER_SIZE);
+	headerBytes	= FORMAT_HEADER_SIZE;
+	return format;
+}
+
+bool	tcpClient::hasChannel	() {
+	return channel != nullptr;
+}
+//
+//	the wideband samples go through the client's down converter,
+//	the result is converted to the client's format
+void	tcpClient::channelData	(const std::complex<int16_t> *v,
+	                                         int size, int nrBits) {
+	if ((int)channelOut. size () < size + groupSamples)
+	   channelOut. resize (size + groupSamples);
+	int amount	= channel -> process (v, size, channelOut. data ());
+	if ((int)channelBytes. size () < amount / groupSamples * groupBytes)
+	   channelBytes. resize (amount / groupSamples * groupBytes);
+	convertSamples (channelOut. data (), amount,
+	                channelBytes. data (), format, nrBits);
+	newData (channelBytes. data (), amount);
+}
+//
+//	the output of the filter bank may not be a multiple of the
+//	group size, what is left is kept for the next time
+void	tcpClient::subbandData	(const std::complex<int16_t> *v,
+	                                         int size, int nrBits) {
+int	amount	= carry. size () + size;
+	if ((int)channelOut. size () < amount)
+	   channelOut. resize (amount);
+	for (int i = 0; i < (int)carry. size (); i ++)
+	   channelOut [i] = carry [i];
+	for (int i = 0; i < size; i ++)
+	   channelOut [carry. size () + i] = v [i];
+	carry. resize (amount % groupSamples);
+	amount	-= carry. size ();
+	for (int i = 0; i < (int)carry. size (); i ++)
+	   carry [i] = channelOut [amount + i];
+	if ((int)channelBytes. size () < amount / groupSamples * groupBytes)
+	   channelBytes. resize (amount / groupSamples * groupBytes);
+	convertSamples (channelOut. data (), amount,
+	                channelBytes. data (), format, nrBits);
+	newData (channelBytes. data (), amount);
+}
+
+void	tcpClient::dropSamples	(int nrSamples) {
+	nrSamplesDropped. fetch_add (nrSamples);
+}
+//
+//	the data is already in the client's format, nrSamples samples,
+//	a multiple of the group size of the format.
+//	Note that newData and flush are both called from the
+//	streamer's thread, so we may skip data at the read side here.
+//	We always skip whole groups, so the client keeps its
+//	alignment, the format header is never skipped
+void	tcpClient::newData	(const uint8_t *v, int nrSamples) {
+int	size	= nrSamples / groupSamples;
+int	space	= outBuffer. GetRingBufferWriteAvailable () / groupBytes;
+int	thePolicy	= policy. load ();
+	if (mustDisconnect. load ())
+	   return;
+	if ((thePolicy == DROP_OLDEST) && (headerBytes > 0))
+	   thePolicy = DROP_NEWEST;
+	if (size > space) {
+	   nrOverflows. fetch_add (1);
+	   switch (thePolicy) {
+	      case DROP_OLDEST: {
+	         int	capacity = (space * groupBytes +
+	                            outBuffer. GetRingBufferReadAvailable ()) /
+	                                                       groupBytes;
+	         if (size > capacity) {	// skip the head of the new data
+	            nrSamplesDropped. fetch_add ((size - capacity) * groupSamples);
+	            v	+= (size - capacity) * groupBytes;
+	            size = capacity;
+	         }
+	         int skipped = outBuffer. skipDataInBuffer (
+	                                     groupBytes * (size - space));
+	         nrSamplesDropped. fetch_add (skipped / groupBytes * groupSamples);
+	         break;
+	      }
+	      case DISCONNECT:
+	         nrSamplesDropped. fetch_add (nrSamples);
+	         mustDisconnect. store (true);
+	         return;
+	      default:		// DROP_NEWEST
+	         nrSamplesDropped. fetch_add ((size - space) * groupSamples);
+	         size	= space;
+	         break;
+	   }
+	}
+	outBuffer. putDataIntoBuffer (v, groupBytes * size);
+}
+//
+//	in the compressed format the data comes in frames, frames
+//	have to be sent completely, so on overflow it is always
+//	the newest frame that is lost
+void	tcpClient::newFrame	(const uint8_t *frame,
+	                         int size, int nrSamples) {
+	if (mustDisconnect. load ())
+	   return;
+	if (outBuffer. GetRingBufferWriteAvailable () < (uint32_t)size) {
+	   nrOverflows. fetch_add (1);
+	   nrSamplesDropped. fetch_add (nrSamples);
+	   if (policy. load () == DISCONNECT)
+	      mustDisconnect. store (true);
+	   return;
+	}
+	outBuffer. putDataIntoBuffer (frame, size);
+}
+//
+//	commands are 5 bytes, a command byte and a 4 byte parameter,
+//	they may arrive in pieces, so we collect them here
+void	tcpClient::addCommandBytes	(const QByteArray &data) {
+	commandBuffer. append (data);
+}
+
+bool	tcpClient::nextCommand	(uint8_t *command) {
+	if (commandBuffer. size () < 5)
+	   return false;
+	for (int i = 0; i < 5; i ++)
+	   command [i] = (uint8_t)(commandBuffer [i]);
+	commandBuffer. remove (0, 5);
+	return true;
+}
+
+//
+//	The data is handed to the kernel directly from the buffer,
+//	the (at most two) regions are passed in a single scatter/gather
+//	call. The read index is advanced with what was actually
+//	written, the remainder stays for the next attempt.
+//	Note that we bypass the QTcpSocket's write buffer, the socket
+//	itself is only used for reading the commands.
+//	Small amounts are held back (coalesced) until either enough
+//	data is available or the oldest data waited long enough
+void	tcpClient::flush	() {
+void	*data1, *data2;
+int32_t	size1, size2;
+int	available	= outBuffer. GetRingBufferReadAvailable ();
+	if (available == 0)
+	   return;
+	auto now	= std::chrono::steady_clock::now ();
+	if (!dataPending) {
+	   dataPending	= true;
+	   pendingSince	= now;
+	}
+	if ((available < coalesceBytes. load ()) &&
+	    (now - pendingSince <
+	           std::chrono::milliseconds (latency_ms. load ())))
+	   return;
+	while (outBuffer. GetRingBufferReadRegions (
+	                              outBuffer. GetRingBufferReadAvailable (),
+	                              &data1, &size1, &data2, &size2) > 0) {
+	   int64_t written = sendRegions (data1, size1, data2, size2);
+	   if (written <= 0)
+	      break;
+	   outBuffer. AdvanceRingBufferReadIndex (written);
+	   nrBytesSent. fetch_add (written);
+	   headerBytes	= written >= headerBytes ? 0 : headerBytes - written;
+	   if (written < size1 + size2)	// socket buffer is full
+	      break;
+	}
+//	what the socket did not take starts a new window, otherwise the
+//	expired deadline would send every small amount at once
+	dataPending	= false;
+}
+
+int64_t	tcpClient::sendRegions	(void *data1, int32_t size1,
+	                         void *data2, int32_t size2) {
+#ifdef	__MINGW32__
+WSABUF	buffers [2];
+DWORD	written	= 0;
+	buffers [0]. buf	= (char *)data1;
+	buffers [0]. len	= size1;
+	buffers [1]. buf	= (char *)data2;
+	buffers [1]. len	= size2;
+	if (WSASend ((SOCKET)(theSocket -> socketDescriptor ()),
+	             buffers, size2 > 0 ? 2 : 1, &written, 0,
+	             nullptr, nullptr) != 0)
+	   return -1;
+	return written;
+#else
+struct iovec	iov [2];
+struct msghdr	msg;
+	iov [0]. iov_base	= data1;
+	iov [0]. iov_len	= size1;
+	iov [1]. iov_base	= data2;
+	iov [1]. iov_len	= size2;
+	memset (&msg, 0, sizeof (msg));
+	msg. msg_iov		= iov;
+	msg. msg_iovlen		= size2 > 0 ? 2 : 1;
+	ssize_t written	= sendmsg (theSocket -> socketDescriptor (), &msg,
+	                           MSG_DONTWAIT | MSG_NOSIGNAL);
+	if (written < 0) {
+	   if ((errno != EAGAIN) && (errno != EWOULDBLOCK))
+	      fprintf (stderr, "client %d: send fails (%s)\n",
+	                                 id, strerror (errno));
+	   return -1;
+	}
+	return written;
+#endif
+}
+
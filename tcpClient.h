@@ -0,0 +1,126 @@
+#
+/*
+ *    Copyright (C)  2025
+ *    Jan van Katwijk (J.vanKatwijk@gmail.com)
+ *    Lazy Chair Computing
+ *
+ *    This file is part of the sdrplayServer
+ *
+ *    sdrplayServer is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    sdrplayServer is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with sdrplayServer; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#pragma once
+
+#include	<stdint.h>
+#include	<complex>
+#include	<atomic>
+#include	<chrono>
+#include	<QTcpSocket>
+#include	<QByteArray>
+#include	<vector>
+#include	"ringbuffer.h"
+#include	"sample-formats.h"
+
+class	ddcChannel;
+//
+//	a client not using a channel of the filter bank
+#define	NO_SUBBAND	0x7FFFFFFF
+
+//
+//	What to do when a client cannot keep up and its buffer is full
+enum	overflowPolicy {
+	DROP_OLDEST	= 0,
+	DROP_NEWEST	= 1,
+	DISCONNECT	= 2
+};
+//
+//	A tcpClient is the server side of a single connection.
+//	Each client has its own (byte) buffer, i.e. its own read cursor
+//	in the sample stream, such that a slow client only looses
+//	its own data and does not affect the other clients.
+//	The buffer is bounded, so memory use and latency are bounded,
+//	on overflow the policy decides what is lost.
+//	The buffer contains the samples in the format the client asked
+//	for (cu8 by default), the conversion is done by the handler,
+//	once per format in use.
+//	A client may ask for a narrow channel instead of the full
+//	band, the client then has its own down converter, or for
+//	one of the channels of the filter bank, which is shared.
+class	tcpClient {
+public:
+		tcpClient	(QTcpSocket *, int clientId,
+	                         int bufferSize, int policy);
+		~tcpClient	();
+	void	newData		(const uint8_t *, int nrSamples);
+	void	newFrame	(const uint8_t *, int size, int nrSamples);
+	void	dropSamples	(int nrSamples);
+	void	flush		();
+	int	activeFormat	(int nrBits, int sampleRate,
+	                                         int subbandRate);
+	void	requestFormat	(int);
+	void	setChannelOffset	(int);
+	void	setChannelRate	(int);
+	bool	hasChannel	();
+	void	channelData	(const std::complex<int16_t> *, int,
+	                                                 int nrBits);
+	void	setSubband	(int);
+	int	subband		();
+	void	subbandData	(const std::complex<int16_t> *, int,
+	                                                 int nrBits);
+	void	addCommandBytes	(const QByteArray &);
+	bool	nextCommand	(uint8_t *);
+	void	setPolicy	(int);
+	void	setCoalescing	(int bytes, int latency_ms);
+	void	setSocketOptions	(bool noDelay, bool cork, int sendBuffer);
+	bool	disconnectRequested	();
+	QTcpSocket	*socket		();
+	int		clientId	();
+	uint64_t	bytesSent	();
+	uint64_t	samplesDropped	();
+	uint64_t	overflows	();
+	int		bufferFill	();
+private:
+	QTcpSocket	*theSocket;
+	int		id;
+	RingBuffer<uint8_t>	outBuffer;
+	std::atomic<int>	policy;
+	std::atomic<bool>	mustDisconnect;
+	std::atomic<uint64_t>	nrBytesSent;
+	std::atomic<uint64_t>	nrSamplesDropped;
+	std::atomic<uint64_t>	nrOverflows;
+	std::atomic<int>	coalesceBytes;
+	std::atomic<int>	latency_ms;
+	std::atomic<int>	requestedFormat;
+	std::atomic<int>	requestedOffset;
+	std::atomic<int>	requestedRate;
+	std::atomic<bool>	reconfigure;
+	ddcChannel	*channel;
+	int		channelInput;
+	std::atomic<int>	requestedSubband;
+	int		theSubband;
+	int		subbandInput;
+	std::vector<std::complex<int16_t>>	carry;
+	std::vector<std::complex<int16_t>>	channelOut;
+	std::vector<uint8_t>	channelBytes;
+	int		format;
+	int		groupSamples;
+	int		groupBytes;
+	int		headerBytes;
+	QByteArray	commandBuffer;
+	bool		dataPending;
+	std::chrono::steady_clock::time_point pendingSince;
+	int64_t		sendRegions	(void *, int32_t, void *, int32_t);
+};
+
@@ -23,12 +23,67 @@
 
 
 #include	"tcpHandler.h"
+#include	"tcpClient.h"
+#include	"sampleCompressor.h"
+#include	"fb-channelizer.h"
 #include	"server.h"
+#include	"settings-handler.h"
+#include	<algorithm>
+
+#define	TCP_SETTINGS	"TCP_SETTINGS"
+//
+//	samples are converted in blocks of this size
+#define	CONVERT_BLOCK	16384
+//
+//	commands with a code >= 0x80 are not rtl_tcp commands, they
+//	apply to the client that sends them and are handled here
+#define	CMD_SET_FORMAT	0x80
+#define	CMD_CHANNEL_OFFSET	0x81
+#define	CMD_CHANNEL_RATE	0x82
+#define	CMD_SUBBAND	0x83
 /*
  *	the actual server
+ *	clientBuffer is the size (in bytes) of the buffer each client gets,
+ *	latencyCap is the max time (in msec) data is held back
+ *	for coalescing, sendBuffer (SO_SNDBUF) 0 means "derive from rate",
+ *	compressBlock is the number of samples in a compressed frame,
+ *	compressLoss the number of low order bits dropped (0 is lossless),
+ *	fbChannels, fbOversampling (1 or 2) and fbTaps (per branch)
+ *	define the filter bank, with fbSpacing (Hz) set the number of
+ *	channels follows from the samplerate
  */
-	TcpHandler::TcpHandler	(Server *theServer, int portNumber) {
+	TcpHandler::TcpHandler	(Server *theServer,
+	                         QSettings *s, int portNumber) {
 	this	-> theServer	= theServer;
+	bufferSize	= value_i (s, TCP_SETTINGS, "clientBuffer", 1024 * 1024);
+	policy		= value_i (s, TCP_SETTINGS, "overflowPolicy", 0);
+	latencyCap	= value_i (s, TCP_SETTINGS, "latencyCap", 20);
+	noDelay		= value_i (s, TCP_SETTINGS, "tcpNoDelay", 1) != 0;
+	cork		= value_i (s, TCP_SETTINGS, "tcpCork", 0) != 0;
+	sendBuffer	= value_i (s, TCP_SETTINGS, "sendBuffer", 0);
+	if (latencyCap < 1)
+	   latencyCap = 1;
+	int compressBlock = value_i (s, TCP_SETTINGS, "compressBlock", 4096);
+	int compressLoss  = value_i (s, TCP_SETTINGS, "compressLoss", 0);
+	if ((compressBlock < 256) || (compressBlock > 65535))
+	   compressBlock = 4096;
+	if ((compressLoss < 0) || (compressLoss > 6))
+	   compressLoss = 0;
+	compressor	= new sampleCompressor (compressBlock, compressLoss);
+	fbChannels	= value_i (s, TCP_SETTINGS, "fbChannels", 64);
+	fbSpacing	= value_i (s, TCP_SETTINGS, "fbSpacing", 0);
+	fbOversampling	= value_i (s, TCP_SETTINGS, "fbOversampling", 2);
+	fbTaps		= value_i (s, TCP_SETTINGS, "fbTaps", 8);
+	channelizer	= nullptr;
+	sampleRate	= 2048000;
+	nrBits		= 12;
+	for (int i = 0; i < NR_FORMATS; i ++)
+	   converted [i]. resize (CONVERT_BLOCK / samplesPerGroup (i, nrBits) *
+	                                          bytesPerGroup (i, nrBits));
+	computeDefaults ();
+	setupChannelizer ();
+	clientCounter	= 0;
+	droppedByGone	= 0;
 	if (!this -> listen (QHostAddress::Any, portNumber)) 
 	   throw (11);
 	setStatus ("I am listening");
@@ -38,29 +93,185 @@
 	         theServer, &Server::dispatch);
 	connect (this, &TcpHandler::setStatus,
 	         theServer, &Server::setStatus);
+//	closeClient is emitted from the streamer's thread
+	connect (this, &TcpHandler::closeClient,
+	         this, &TcpHandler::closeSocket, Qt::QueuedConnection);
 	running. store (true);
 }
 
 	TcpHandler::~TcpHandler	() {
+	running. store (false);
+	std::lock_guard<std::mutex> lock (clientLocker);
+	for (auto client : clients) {
+	   client -> socket () -> close ();
+	   delete client;
+	}
+	clients. clear ();
+	delete compressor;
+	delete channelizer;
+}
+//
+//	the filter bank depends on the samplerate, it is (re)created
+//	in the GUI thread, with the clientLocker locked (or before
+//	there are any clients)
+void	TcpHandler::setupChannelizer	() {
+int	n	= fbChannels;
+	if (fbSpacing > 0)
+	   n	= sampleRate / fbSpacing;
+	if (n < 2)
+	   n	= 2;
+	if (n > 4096)
+	   n	= 4096;
+	delete channelizer;
+	channelizer	= new fbChannelizer (sampleRate, n,
+	                                     fbOversampling, fbTaps);
+}
+
+//
+//	the defaults depend on the amount of data we send, i.e. on
+//	the samplerate: we try to send about 4 chunks within the
+//	latency cap and let the kernel buffer a few latency caps
+void	TcpHandler::computeDefaults	() {
+int	bytesPerMsec	= sampleRate / 1000 * 2;
+	coalesceBytes	= bytesPerMsec * latencyCap / 4;
+	if (coalesceBytes < 4096)
+	   coalesceBytes = 4096;
+	if (coalesceBytes > bufferSize / 4)
+	   coalesceBytes = bufferSize / 4;
+	socketBuffer	= sendBuffer;
+	if (socketBuffer <= 0) {
+	   socketBuffer	= 4 * bytesPerMsec * latencyCap;
+	   if (socketBuffer < 64 * 1024)
+	      socketBuffer = 64 * 1024;
+	   if (socketBuffer > 4 * 1024 * 1024)
+	      socketBuffer = 4 * 1024 * 1024;
+	}
+}
+
+void	TcpHandler::setSampleRate	(int rate) {
+	std::lock_guard<std::mutex> lock (clientLocker);
+	sampleRate	= rate;
+	computeDefaults ();
+	setupChannelizer ();
+	for (auto client : clients) {
+	   client -> setCoalescing (coalesceBytes, latencyCap);
+	   client -> setSocketOptions (noDelay, cork, socketBuffer);
+	}
+}
+
+void	TcpHandler::setBitDepth	(int nrBits) {
+	std::lock_guard<std::mutex> lock (clientLocker);
+	this	-> nrBits	= nrBits;
+	compressor	-> setBitDepth (nrBits);
+	for (int i = 0; i < NR_FORMATS; i ++)
+	   converted [i]. resize (CONVERT_BLOCK / samplesPerGroup (i, nrBits) *
+	                                          bytesPerGroup (i, nrBits));
+}
+
+void	TcpHandler::setNotifier	(sampleNotifier *n) {
+	compressor	-> setNotifier (n);
+}
+
+//
+//	the streamer was overrun, the clients miss these samples
+void	TcpHandler::samplesLost	(int nrSamples) {
+	std::lock_guard<std::mutex> lock (clientLocker);
+	for (auto client : clients)
+	   client -> dropSamples (nrSamples);
+}
+
+int	TcpHandler::latency	() {
+	return latencyCap;
+}
+
+void	TcpHandler::setPolicy	(int policy) {
+	std::lock_guard<std::mutex> lock (clientLocker);
+	this	-> policy	= policy;
+	for (auto client : clients)
+	   client -> setPolicy (policy);
+}
+
+QString	TcpHandler::statistics	() {
+uint64_t dropped	= droppedByGone;
+uint64_t overflows	= 0;
+int	maxFill		= 0;
+	std::lock_guard<std::mutex> lock (clientLocker);
+	for (auto client : clients) {
+	   dropped	+= client -> samplesDropped ();
+	   overflows	+= client -> overflows ();
+	   if (client -> bufferFill () > maxFill)
+	      maxFill = client -> bufferFill ();
+	}
+	return QString ("clients ") + QString::number (clients. size ()) +
+	       " dropped " + QString::number ((qulonglong)dropped) +
+	       " overflows " + QString::number ((qulonglong)overflows) +
+	       " fill " + QString::number (maxFill) + "% " +
+	       compressor -> statistics ();
+}
+
+int	TcpHandler::nrClients	() {
+	std::lock_guard<std::mutex> lock (clientLocker);
+	return clients. size ();
+}
+
+tcpClient	*TcpHandler::findClient	(QTcpSocket *socket) {
+	std::lock_guard<std::mutex> lock (clientLocker);
+	for (auto client : clients)
+	   if (client -> socket () == socket)
+	      return client;
+	return nullptr;
+}
+
+void	TcpHandler::removeClient	(QTcpSocket *socket) {
+	clientLocker. lock ();
+	for (auto it = clients. begin (); it != clients. end (); it ++) {
+	   if ((*it) -> socket () == socket) {
+	      tcpClient *client = *it;
+	      fprintf (stderr, "client %d left, %lu bytes sent, %lu samples dropped\n",
+	                       client -> clientId (),
+	                       (unsigned long)(client -> bytesSent ()),
+	                       (unsigned long)(client -> samplesDropped ()));
+	      droppedByGone	+= client -> samplesDropped ();
+	      clients. erase (it);
+	      delete client;
+	      break;
+	   }
+	}
+	clientLocker. unlock ();
+	showClients ();
+}
+
+void	TcpHandler::showClients	() {
+int	n	= nrClients ();
+	if (n == 0)
+	   setStatus ("I am listening");
+	else
+	   setStatus (QString::number (n) + " client(s) connected");
 }
 
-static bool	connected	= false;
 void    TcpHandler::newConnection      () {
-	if (this -> hasPendingConnections ()) {
-	   theSocket = this -> nextPendingConnection ();
+	while (this -> hasPendingConnections ()) {
+	   QTcpSocket *theSocket = this -> nextPendingConnection ();
 	   connect (theSocket, &QTcpSocket::readyRead,
 	            this, &TcpHandler::readSocket);
 	   connect (theSocket, &QAbstractSocket::disconnected,
                     this, &TcpHandler::discardSocket);
            connect  (theSocket, &QTcpSocket::errorOccurred,
                      this, &TcpHandler::onSocketError);
-	   connected = true;
-	   setStatus ("I am connected");
+	   tcpClient *client = new tcpClient (theSocket, clientCounter ++,
+	                                      bufferSize, policy);
+	   clientLocker. lock ();
+	   client -> setCoalescing (coalesceBytes, latencyCap);
+	   client -> setSocketOptions (noDelay, cork, socketBuffer);
+	   clients. push_back (client);
+	   clientLocker. unlock ();
+	   showClients ();
         }
 }
 
 void	TcpHandler::discardSocket () {
 QTcpSocket *socket = reinterpret_cast<QTcpSocket*>(sender());
+	removeClient (socket);
 	socket -> deleteLater ();
 	socket	-> close ();
 }
@@ -68,27 +279,174 @@ QTcpSocket *socket = reinterpret_cast<QTcpSocket*>(sender());
 void	TcpHandler::onSocketError (QAbstractSocket::SocketError socketerror) {
 QTcpSocket *socket = reinterpret_cast<QTcpSocket*>(sender());
 	fprintf (stderr, "Error %d\n", (int)socketerror);
-	theSocket	-> close ();
-	theSocket	= nullptr;
-	setStatus ("I am listening");
+	removeClient (socket);
+	socket	-> deleteLater ();
+	socket	-> close ();
 }
-
-void    TcpHandler::readSocket () {
-	if (theSocket == nullptr)
+//
+//	a client that could not keep up with the disconnect policy
+void	TcpHandler::closeSocket	(QTcpSocket *socket) {
+	if (findClient (socket) == nullptr)
 	   return;
-	QByteArray data	= theSocket -> readAll ();
-	dispatch (data);
+	fprintf (stderr, "client cannot keep up, disconnected\n");
+	socket	-> close ();
 }
-
-void	TcpHandler::newData	(std::complex<uint8_t> *v, int size) {
-QByteArray theData;
-	if (!connected || (theSocket == nullptr))
+//
+//	commands from any of the clients are passed on, all clients
+//	share the same device. The extended commands are for the
+//	client itself
+void    TcpHandler::readSocket () {
+QTcpSocket *socket = reinterpret_cast<QTcpSocket*>(sender());
+tcpClient *client	= findClient (socket);
+uint8_t	command [5];
+QByteArray toDevice;
+	if (client == nullptr)
 	   return;
-	theData. resize (2 * size);
-	for (int i = 0; i < size; i ++) {
-	  theData [2 * i]	= real (v [i]);
-	  theData [2 * i + 1]	= imag (v [i]);
+	client	-> addCommandBytes (socket -> readAll ());
+	while (client -> nextCommand (command)) {
+	   if (command [0] >= 0x80)
+	      clientCommand (client, command);
+	   else
+	      toDevice. append ((const char *)command, 5);
 	}
-	theSocket	-> write (theData);
+	if (toDevice. size () > 0)
+	   dispatch (toDevice);
 }
 
+void	TcpHandler::clientCommand	(tcpClient *client, uint8_t *command) {
+uint32_t param	= (command [1] << 24) | (command [2] << 16) |
+	          (command [3] << 8) | command [4];
+	switch (command [0]) {
+	   case CMD_SET_FORMAT:
+	      if (!validFormat (param)) {
+	         fprintf (stderr, "client %d: unknown format %d\n",
+	                               client -> clientId (), (int)param);
+	         break;
+	      }
+	      client	-> requestFormat (param);
+	      break;
+//	a narrow channel, offset (signed) Hz from the center
+	   case CMD_CHANNEL_OFFSET:
+	      client	-> setChannelOffset ((int32_t)param);
+	      break;
+	   case CMD_CHANNEL_RATE:		// 0 also ends a subband
+	      client	-> setSubband (NO_SUBBAND);
+	      client	-> setChannelRate (param);
+	      break;
+//	a channel of the filter bank, relative to the center channel
+	   case CMD_SUBBAND: {
+	      std::lock_guard<std::mutex> lock (clientLocker);
+	      if (!channelizer -> validChannel ((int32_t)param)) {
+	         fprintf (stderr, "client %d: no subband %d\n",
+	                               client -> clientId (), (int)param);
+	         break;
+	      }
+	      client	-> setChannelRate (0);
+	      client	-> setSubband ((int32_t)param);
+	      break;
+	   }
+	   default:
+	      fprintf (stderr, "client %d: unknown command %x\n",
+	                               client -> clientId (), command [0]);
+	      break;
+	}
+}
+//
+//	The samples are converted once for each format in use, in blocks,
+//	so the converted data stays in the cache while it is copied into
+//	the buffers of the clients. The streamer passes an even number
+//	of samples, a block is even as well, so the packed groups
+//	(at most 2 samples) never cross a call
+void	TcpHandler::newData	(const std::complex<int16_t> *v, int size) {
+bool	compress	= false;
+	std::lock_guard<std::mutex> lock (clientLocker);
+	for (int offset = 0; offset < size; offset += CONVERT_BLOCK) {
+	   int	amount	= std::min (CONVERT_BLOCK, size - offset);
+	   bool	done [NR_FORMATS]	= {false};
+	   bool	useBank	= false;
+	   channelizer	-> clearActive ();
+	   for (auto client : clients) {
+	      if (client -> disconnectRequested ())
+	         continue;
+	      int format = client -> activeFormat (nrBits, sampleRate,
+	                                         channelizer -> outRate ());
+	      if (format < 0) {
+	         client -> dropSamples (amount);
+	         continue;
+	      }
+	      if (format == FORMAT_COMPRESSED) {
+	         compress	= true;
+	         continue;
+	      }
+	      if (client -> hasChannel ()) {
+	         client -> channelData (&v [offset], amount, nrBits);
+	         if (client -> disconnectRequested ())
+	            closeClient (client -> socket ());
+	         continue;
+	      }
+	      if (client -> subband () != NO_SUBBAND) {
+	         channelizer	-> setActive (client -> subband ());
+	         useBank	= true;
+	         continue;
+	      }
+	      if (!done [format]) {
+	         convertSamples (&v [offset], amount,
+	                         converted [format]. data (), format, nrBits);
+	         done [format] = true;
+	      }
+	      client -> newData (converted [format]. data (), amount);
+	      if (client -> disconnectRequested ())
+	         closeClient (client -> socket ());
+	   }
+//
+//	one pass of the filter bank serves all its clients
+	   if (!useBank)
+	      continue;
+	   channelizer	-> process (&v [offset], amount);
+	   for (auto client : clients) {
+	      const std::complex<int16_t> *out;
+	      if (client -> disconnectRequested () ||
+	                          (client -> subband () == NO_SUBBAND))
+	         continue;
+	      int n	= channelizer -> output (client -> subband (), &out);
+	      client	-> subbandData (out, n, nrBits);
+	      if (client -> disconnectRequested ())
+	         closeClient (client -> socket ());
+	   }
+	}
+	if (compress)
+	   compressor -> newData (v, size);
+	sendFrames ();
+	for (auto client : clients)
+	   if (!client -> disconnectRequested ())
+	      client -> flush ();
+}
+//
+//	the frames of the compressor go to the clients using the
+//	compressed format, called with the clientLocker locked
+void	TcpHandler::sendFrames	() {
+	while (compressor -> nextFrame (frame)) {
+	   int nrSamples	= (frame [4] << 8) | frame [5];
+	   for (auto client : clients) {
+	      if (client -> disconnectRequested ())
+	         continue;
+	      if (client -> activeFormat (nrBits, sampleRate,
+	                          channelizer -> outRate ()) != FORMAT_COMPRESSED)
+	         continue;
+	      client -> newFrame (frame. data (), frame. size (), nrSamples);
+	      if (client -> disconnectRequested ())
+	         closeClient (client -> socket ());
+	   }
+	}
+}
+//
+//	called by the streamer when there is no new data, such that
+//	data held back for coalescing is sent in time, and the
+//	frames of the compressor are sent as soon as they are ready
+void	TcpHandler::flush	() {
+	std::lock_guard<std::mutex> lock (clientLocker);
+	sendFrames ();
+	for (auto client : clients)
+	   if (!client -> disconnectRequested ())
+	      client -> flush ();
+}
@@ -27,32 +27,86 @@
 #include	<QByteArray>
 #include	<complex>
 #include	<atomic>
+#include	<vector>
+#include	<mutex>
 #include        <QTcpSocket>
 #include        <QTcpServer>
 #include        <QAbstractSocket>
+#include	"sample-formats.h"
 
 class	Server;
+class	QSettings;
+class	tcpClient;
+class	sampleCompressor;
+class	sampleNotifier;
+class	fbChannelizer;
 /*
- *	the actual server
+ *	the actual server, it accepts any number of clients, all
+ *	clients are fed from the same sample stream.
+ *	Note that newData is called from the streamer's thread, the
+ *	other functions run in the GUI thread
  */
 class TcpHandler: public QTcpServer {
 Q_OBJECT
 public:
-		TcpHandler	(Server *, int portNumber);
+		TcpHandler	(Server *, QSettings *, int portNumber);
 		~TcpHandler	();
-	void	newData		(std::complex<uint8_t> *, int);
+	void	newData		(const std::complex<int16_t> *, int);
+	void	flush		();
+	void	samplesLost	(int);
+	int	nrClients	();
+	void	setPolicy	(int);
+	void	setSampleRate	(int);
+	void	setBitDepth	(int);
+	void	setNotifier	(sampleNotifier *);
+	int	latency		();
+	QString	statistics	();
 private:
 //	QSettings	*spectrumSettings;
 	Server		*theServer;
 	std::atomic<bool> running;
-	QTcpSocket	*theSocket;
+	std::vector<tcpClient *> clients;
+	std::mutex	clientLocker;
+	int		clientCounter;
+	int		bufferSize;
+	int		policy;
+	uint64_t	droppedByGone;
+//	socket tuning and coalescing
+	int		sampleRate;
+	int		latencyCap;
+	bool		noDelay;
+	bool		cork;
+	int		sendBuffer;
+	int		coalesceBytes;
+	int		socketBuffer;
+//	conversion to the formats the clients asked for
+	int		nrBits;
+	std::vector<uint8_t> converted [NR_FORMATS];
+	void		clientCommand	(tcpClient *, uint8_t *);
+//	the filter bank, shared by the clients using its channels
+	fbChannelizer	*channelizer;
+	int		fbChannels;
+	int		fbSpacing;
+	int		fbOversampling;
+	int		fbTaps;
+	void		setupChannelizer	();
+//	the compressed stream
+	sampleCompressor	*compressor;
+	std::vector<uint8_t>	frame;
+	void		sendFrames	();
+	void		computeDefaults	();
+	tcpClient	*findClient	(QTcpSocket *);
+	void		removeClient	(QTcpSocket *);
+	void		showClients	();
 public slots:
 	void		newConnection	();
 	void		readSocket	();
 	void		discardSocket	();
 	void		onSocketError	(QAbstractSocket::SocketError);
+	void		closeSocket	(QTcpSocket *);
 signals:
 	void		dispatch	(QByteArray &);
 	void		setStatus	(const QString &);
+	void		closeClient	(QTcpSocket *);
 };
 
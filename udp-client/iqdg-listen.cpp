@@ -0,0 +1,82 @@
+#
+/*
+ *    Copyright (C) 2025
+ *    Jan van Katwijk (J.vanKatwijk@gmail.com)
+ *    Lazy Chair Computing
+ *
+ *    This file is part of sdrplay_tcp
+ *
+ *    sdrplay_tcp is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    sdrplay_tcp is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with sdrplay_tcp; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+//
+//	Listens to the IQDG datagrams of the sdrplayServer and prints,
+//	once a second, what arrived and how many datagrams were lost.
+//	For a loopback test run the server with udpEnabled and
+//	udpInterface 127.0.0.1, and
+//
+//	iqdg-listen [address [port [seconds [interface]]]]
+//
+//	the defaults are those of the server, 239.255.12.34 and 1235,
+//	it listens for 10 seconds (on interface 127.0.0.1 for the
+//	loopback test). The exit status is 1 if datagrams were lost.
+//	Build with
+//	g++ -O2 -o iqdg-listen iqdg-listen.cpp udp-receiver.cpp
+#include	"udp-receiver.h"
+#include	<stdio.h>
+#include	<stdlib.h>
+#include	<chrono>
+#include	<stdexcept>
+
+int	main	(int argc, char **argv) {
+const char *address	= argc > 1 ? argv [1] : "239.255.12.34";
+int	port		= argc > 2 ? atoi (argv [2]) : 1235;
+int	seconds		= argc > 3 ? atoi (argv [3]) : 10;
+const char *ifAddress	= argc > 4 ? argv [4] : "";
+static uint8_t	payload [65536];
+iqdgHeader	h;
+uint64_t	bytes	= 0;
+uint64_t	samples	= 0;
+	try {
+	   udpReceiver	receiver (address, port, ifAddress);
+	   auto start	= std::chrono::steady_clock::now ();
+	   auto next	= start + std::chrono::seconds (1);
+	   h. format	= h. nrBits = h. sampleRate = 0;
+	   while (next <= start + std::chrono::seconds (seconds)) {
+	      int n	= receiver. receive (h, payload, sizeof (payload), 100);
+	      if (n >= 0) {
+	         bytes		+= n;
+	         samples	+= h. nrSamples;
+	      }
+	      if (std::chrono::steady_clock::now () < next)
+	         continue;
+	      printf ("%llu datagrams, %llu lost, %llu reordered, "
+	              "%llu samples, %llu bytes "
+	              "(format %d, %d bits, %d S/s)\n",
+	              (unsigned long long)receiver. received (),
+	              (unsigned long long)receiver. lost (),
+	              (unsigned long long)receiver. reordered (),
+	              (unsigned long long)samples,
+	              (unsigned long long)bytes,
+	              h. format, h. nrBits, h. sampleRate);
+	      next	+= std::chrono::seconds (1);
+	   }
+	   return receiver. lost () == 0 ? 0 : 1;
+	} catch (std::exception &e) {
+	   fprintf (stderr, "iqdg-listen: %s\n", e. what ());
+	   return 2;
+	}
+}
+
@@ -0,0 +1,143 @@
+#
+/*
+ *    Copyright (C) 2025
+ *    Jan van Katwijk (J.vanKatwijk@gmail.com)
+ *    Lazy Chair Computing
+ *
+ *    This file is part of sdrplay_tcp
+ *
+ *    sdrplay_tcp is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    sdrplay_tcp is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with sdrplay_tcp; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include	"udp-receiver.h"
+#include	<sys/types.h>
+#include	<sys/socket.h>
+#include	<netinet/in.h>
+#include	<arpa/inet.h>
+#include	<unistd.h>
+#include	<poll.h>
+#include	<string.h>
+#include	<stdexcept>
+
+	udpReceiver::udpReceiver	(const char *address, int port,
+	                                 const char *ifAddress) {
+struct sockaddr_in local;
+struct in_addr	group;
+int	reuse	= 1;
+	if (inet_pton (AF_INET, address, &group) != 1)
+	   throw std::runtime_error ("not a valid address");
+	fd	= socket (AF_INET, SOCK_DGRAM, 0);
+	if (fd < 0)
+	   throw std::runtime_error ("cannot create a socket");
+//	more receivers on this host may listen to the same group
+	setsockopt (fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof (reuse));
+	memset (&local, 0, sizeof (local));
+	local. sin_family	= AF_INET;
+	local. sin_port		= htons (port);
+	local. sin_addr. s_addr	= IN_MULTICAST (ntohl (group. s_addr)) ?
+	                                     group. s_addr : htonl (INADDR_ANY);
+	if (bind (fd, (struct sockaddr *)&local, sizeof (local)) < 0) {
+	   close (fd);
+	   throw std::runtime_error ("cannot bind to the port");
+	}
+	if (IN_MULTICAST (ntohl (group. s_addr))) {
+	   struct ip_mreq mreq;
+	   mreq. imr_multiaddr	= group;
+	   mreq. imr_interface. s_addr	= htonl (INADDR_ANY);
+	   if ((ifAddress [0] != 0) &&
+	       (inet_pton (AF_INET, ifAddress,
+	                   &mreq. imr_interface) != 1)) {
+	      close (fd);
+	      throw std::runtime_error ("not a valid interface address");
+	   }
+	   if (setsockopt (fd, IPPROTO_IP, IP_ADD_MEMBERSHIP,
+	                          &mreq, sizeof (mreq)) < 0) {
+	      close (fd);
+	      throw std::runtime_error ("cannot join the group");
+	   }
+	}
+	first		= true;
+	expected	= 0;
+	nrReceived	= 0;
+	nrLost		= 0;
+	nrReordered	= 0;
+}
+
+	udpReceiver::~udpReceiver	() {
+	close (fd);
+}
+
+uint64_t udpReceiver::received	() {
+	return nrReceived;
+}
+
+uint64_t udpReceiver::lost	() {
+	return nrLost;
+}
+
+uint64_t udpReceiver::reordered	() {
+	return nrReordered;
+}
+
+static inline
+uint32_t get_32	(const uint8_t *b) {
+	return ((uint32_t)b [0] << 24) | ((uint32_t)b [1] << 16) |
+	       ((uint32_t)b [2] << 8) | b [3];
+}
+
+static inline
+uint16_t get_16	(const uint8_t *b) {
+	return (b [0] << 8) | b [1];
+}
+//
+//	returns the number of payload bytes copied, -1 on a timeout or
+//	when the datagram is not an IQDG one. A gap in the sequence
+//	numbers is counted as lost datagrams, a number from before
+//	the expected one as a reordered (or duplicated) datagram
+int	udpReceiver::receive	(iqdgHeader &h, uint8_t *payload,
+	                         int maxBytes, int timeout_ms) {
+struct pollfd	p;
+	p. fd		= fd;
+	p. events	= POLLIN;
+	if (poll (&p, 1, timeout_ms) <= 0)
+	   return -1;
+	ssize_t	size	= recv (fd, datagram, sizeof (datagram), 0);
+	if ((size < IQDG_HEADER_SIZE) || (memcmp (datagram, "IQDG", 4) != 0))
+	   return -1;
+	h. sequence	= get_32 (&datagram [4]);
+	h. format	= datagram [8];
+	h. nrBits	= datagram [9];
+	h. nrSamples	= get_16 (&datagram [10]);
+	h. sampleRate	= get_32 (&datagram [12]);
+	nrReceived ++;
+	if (first) {
+	   first	= false;
+	   expected	= h. sequence + 1;
+	}
+	else {
+	   int32_t gap	= (int32_t)(h. sequence - expected);
+	   if (gap < 0)
+	      nrReordered ++;
+	   else {
+	      nrLost	+= gap;
+	      expected	= h. sequence + 1;
+	   }
+	}
+	int amount	= size - IQDG_HEADER_SIZE < maxBytes ?
+	                          size - IQDG_HEADER_SIZE : maxBytes;
+	memcpy (payload, &datagram [IQDG_HEADER_SIZE], amount);
+	return amount;
+}
+
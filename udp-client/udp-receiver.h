@@ -0,0 +1,72 @@
+#
+/*
+ *    Copyright (C) 2025
+ *    Jan van Katwijk (J.vanKatwijk@gmail.com)
+ *    Lazy Chair Computing
+ *
+ *    This file is part of sdrplay_tcp
+ *
+ *    sdrplay_tcp is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    sdrplay_tcp is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with sdrplay_tcp; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#pragma once
+
+#include	<stdint.h>
+
+//
+//	A receiver for the IQDG datagrams the sdrplayServer publishes
+//	(see udpHandler.h), without Qt. It joins the multicast group
+//	(a unicast address is just bound to), decodes the header and
+//	checks the sequence numbers.
+//
+//	udpReceiver receiver ("239.255.12.34", 1235);
+//	iqdgHeader	h;
+//	uint8_t	payload [65536];
+//	while (true) {
+//	   int n = receiver. receive (h, payload, sizeof (payload), 100);
+//	   if (n < 0)		// a timeout, or not an IQDG datagram
+//	      continue;
+//	   ... n bytes, h. nrSamples samples in format h. format
+//	}
+#define	IQDG_HEADER_SIZE	16
+
+struct	iqdgHeader {
+	uint32_t	sequence;
+	int		format;		// as in sample-formats.h
+	int		nrBits;
+	int		nrSamples;
+	int		sampleRate;
+};
+
+class	udpReceiver {
+public:
+		udpReceiver	(const char *address, int port,
+	                         const char *ifAddress = "");
+		~udpReceiver	();
+	int	receive		(iqdgHeader &, uint8_t *payload,
+	                         int maxBytes, int timeout_ms);
+	uint64_t	received	();
+	uint64_t	lost		();
+	uint64_t	reordered	();
+private:
+	int		fd;
+	bool		first;
+	uint32_t	expected;
+	uint64_t	nrReceived;
+	uint64_t	nrLost;
+	uint64_t	nrReordered;
+	uint8_t		datagram [65536];
+};
+
@@ -0,0 +1,218 @@
+#
+/*
+ *    Copyright (C)  2025
+ *    Jan van Katwijk (J.vanKatwijk@gmail.com)
+ *    Lazy Chair Computing
+ *
+ *    This file is part of the sdrplayServer
+ *
+ *    sdrplayServerr is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    sdrplayServer is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with sdrplayServerr; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include	"udpHandler.h"
+#include	"sample-formats.h"
+#include	"settings-handler.h"
+#include	<string.h>
+#include	<stdio.h>
+#include	<algorithm>
+#ifdef	__MINGW32__
+#include	<ws2tcpip.h>
+#else
+#include	<sys/types.h>
+#include	<sys/socket.h>
+#include	<arpa/inet.h>
+#include	<unistd.h>
+#include	<errno.h>
+#endif
+
+#define	UDP_SETTINGS	"UDP_SETTINGS"
+#define	CONVERT_BLOCK	16384
+/*
+ *	udpAddress is the (multicast) address the datagrams are sent
+ *	to, udpPort the port, datagramSize the size of a datagram,
+ *	header included (1472 fits in an ethernet frame), udpTtl the
+ *	ttl, udpInterface the address of the interface used
+ *	for multicast ("" is the default) and udpFormat the
+ *	format (as in sample-formats.h, compressed is not supported)
+ */
+	UdpHandler::UdpHandler	(QSettings *s) {
+QString	address	= value_s (s, UDP_SETTINGS, "udpAddress", "239.255.12.34");
+int	port	= value_i (s, UDP_SETTINGS, "udpPort", 1235);
+int	ttl	= value_i (s, UDP_SETTINGS, "udpTtl", 1);
+QString	ifAddress = value_s (s, UDP_SETTINGS, "udpInterface", "");
+int	loop	= 1;
+	datagramSize	= value_i (s, UDP_SETTINGS, "datagramSize", 1472);
+	format		= value_i (s, UDP_SETTINGS, "udpFormat", FORMAT_CS16);
+	if (!validFormat (format) || (format == FORMAT_COMPRESSED))
+	   format	= FORMAT_CS16;
+	if (datagramSize < DATAGRAM_HEADER_SIZE + 64)
+	   datagramSize = DATAGRAM_HEADER_SIZE + 64;
+	if (datagramSize > 65507)
+	   datagramSize = 65507;
+
+	memset (&target, 0, sizeof (target));
+	target. sin_family	= AF_INET;
+	target. sin_port	= htons (port);
+	if (inet_pton (AF_INET, address. toLatin1 (). data (),
+	                                     &target. sin_addr) != 1) {
+	   fprintf (stderr, "udp: invalid address %s\n",
+	                                address. toLatin1 (). data ());
+	   throw (21);
+	}
+	socketFd	= socket (AF_INET, SOCK_DGRAM, 0);
+	if (socketFd < 0)
+	   throw (22);
+#ifdef	__MINGW32__
+//	winsock has no MSG_DONTWAIT, the socket itself is made non blocking
+u_long	nonBlocking	= 1;
+	ioctlsocket (socketFd, FIONBIO, &nonBlocking);
+#endif
+
+	if (IN_MULTICAST (ntohl (target. sin_addr. s_addr))) {
+	   setsockopt (socketFd, IPPROTO_IP, IP_MULTICAST_TTL,
+	                              (char *)&ttl, sizeof (ttl));
+	   setsockopt (socketFd, IPPROTO_IP, IP_MULTICAST_LOOP,
+	                              (char *)&loop, sizeof (loop));
+	   if (ifAddress != "") {
+	      struct in_addr ifa;
+	      if (inet_pton (AF_INET, ifAddress. toLatin1 (). data (),
+	                                               &ifa) == 1)
+	         setsockopt (socketFd, IPPROTO_IP, IP_MULTICAST_IF,
+	                              (char *)&ifa, sizeof (ifa));
+	      else
+	         fprintf (stderr, "udp: invalid interface %s\n",
+	                               ifAddress. toLatin1 (). data ());
+	   }
+	}
+	else
+	   setsockopt (socketFd, IPPROTO_IP, IP_TTL,
+	                              (char *)&ttl, sizeof (ttl));
+
+	nrBits. store (12);
+	sampleRate. store (2048000);
+	currentBits	= 0;
+	sequence	= 0;
+	fill		= 0;
+	samplesInDatagram	= 0;
+	datagram. resize (datagramSize);
+	nrSent. store (0);
+	nrFailed. store (0);
+	nrDropped. store (0);
+}
+
+	UdpHandler::~UdpHandler	() {
+#ifdef	__MINGW32__
+	closesocket (socketFd);
+#else
+	close (socketFd);
+#endif
+}
+
+void	UdpHandler::setSampleRate	(int rate) {
+	sampleRate. store (rate);
+}
+
+void	UdpHandler::setBitDepth	(int nrBits) {
+	this	-> nrBits. store (nrBits);
+}
+
+QString	UdpHandler::statistics	() {
+	return QString ("udp ") + QString::number ((qulonglong)nrSent. load ()) +
+	       " sent " + QString::number ((qulonglong)nrDropped. load ()) +
+	       " dropped " + QString::number ((qulonglong)nrFailed. load ()) +
+	       " failed";
+}
+
+static inline
+void	put_16	(uint8_t *b, uint16_t v) {
+	b [0]	= (v >> 8) & 0xFF;
+	b [1]	= v & 0xFF;
+}
+
+static inline
+void	put_32	(uint8_t *b, uint32_t v) {
+	b [0]	= (v >> 24) & 0xFF;
+	b [1]	= (v >> 16) & 0xFF;
+	b [2]	= (v >>  8) & 0xFF;
+	b [3]	= v & 0xFF;
+}
+//
+//	A datagram only contains whole groups (see sample-formats.h).
+//	The send never blocks the streamer: if the kernel buffer is
+//	full the datagram is dropped, if sending fails otherwise it is
+//	lost as well. The sequence number is incremented anyway, so the
+//	receivers see the loss
+void	UdpHandler::sendDatagram	() {
+uint8_t	*h	= datagram. data ();
+#ifdef	__MINGW32__
+int	flags	= 0;
+#else
+int	flags	= MSG_DONTWAIT | MSG_NOSIGNAL;
+#endif
+	h [0]	= 'I';
+	h [1]	= 'Q';
+	h [2]	= 'D';
+	h [3]	= 'G';
+	put_32 (&h [4], sequence ++);
+	h [8]	= format;
+	h [9]	= currentBits;
+	put_16 (&h [10], samplesInDatagram);
+	put_32 (&h [12], sampleRate. load ());
+	if (sendto (socketFd, (const char *)h, DATAGRAM_HEADER_SIZE + fill,
+	            flags, (struct sockaddr *)&target, sizeof (target)) >= 0)
+	   nrSent. fetch_add (1);
+	else
+#ifdef	__MINGW32__
+	if (WSAGetLastError () == WSAEWOULDBLOCK)
+#else
+	if ((errno == EAGAIN) || (errno == EWOULDBLOCK))
+#endif
+	   nrDropped. fetch_add (1);
+	else
+	   nrFailed. fetch_add (1);
+	fill	= 0;
+	samplesInDatagram	= 0;
+}
+
+void	UdpHandler::newData	(const std::complex<int16_t> *v, int size) {
+int	room;
+	if (nrBits. load () != currentBits) {
+	   currentBits	= nrBits. load ();
+	   groupSamples	= samplesPerGroup (format, currentBits);
+	   groupBytes	= bytesPerGroup (format, currentBits);
+	   converted. resize (CONVERT_BLOCK / groupSamples * groupBytes);
+	   fill		= 0;		// a partial datagram is lost
+	   samplesInDatagram	= 0;
+	}
+	room	= (datagramSize - DATAGRAM_HEADER_SIZE) / groupBytes;
+	for (int offset = 0; offset < size; offset += CONVERT_BLOCK) {
+	   int	amount	= std::min (CONVERT_BLOCK, size - offset);
+	   convertSamples (&v [offset], amount,
+	                   converted. data (), format, currentBits);
+	   int	groups	= amount / groupSamples;
+	   int	index	= 0;
+	   while (index < groups) {
+	      int n	= std::min (groups - index, room - fill / groupBytes);
+	      memcpy (&datagram [DATAGRAM_HEADER_SIZE + fill],
+	              &converted [index * groupBytes], n * groupBytes);
+	      fill		+= n * groupBytes;
+	      samplesInDatagram	+= n * groupSamples;
+	      index		+= n;
+	      if (fill / groupBytes == room)
+	         sendDatagram ();
+	   }
+	}
+}
+
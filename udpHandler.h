@@ -0,0 +1,78 @@
+#
+/*
+ *    Copyright (C)  2025
+ *    Jan van Katwijk (J.vanKatwijk@gmail.com)
+ *    Lazy Chair Computing
+ *
+ *    This file is part of the sdrplayServer
+ *
+ *    sdrplayServerr is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    sdrplayServer is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with sdrplayServerr; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#pragma once
+
+#include	<QString>
+#include	<atomic>
+#include	<complex>
+#include	<vector>
+#include	<stdint.h>
+#ifdef	__MINGW32__
+#include	<winsock2.h>
+#else
+#include	<netinet/in.h>
+#endif
+
+class	QSettings;
+//
+//	The UdpHandler publishes the samples as datagrams to a unicast
+//	address or a multicast group, so any number of receivers can
+//	listen at the cost of a single stream.
+//	Each datagram has a 16 byte header:
+//	"IQDG", sequence number (4 bytes), format, nrBits,
+//	number of samples (2 bytes), samplerate (4 bytes),
+//	multibyte values are big endian. A gap in the sequence
+//	numbers tells the receiver datagrams were lost.
+//	newData is called from the streamer's thread.
+#define	DATAGRAM_HEADER_SIZE	16
+
+class	UdpHandler {
+public:
+		UdpHandler	(QSettings *);
+		~UdpHandler	();
+	void	newData		(const std::complex<int16_t> *, int);
+	void	setSampleRate	(int);
+	void	setBitDepth	(int);
+	QString	statistics	();
+private:
+	int		socketFd;
+	struct sockaddr_in	target;
+	int		datagramSize;
+	int		format;
+	std::atomic<int>	nrBits;
+	std::atomic<int>	sampleRate;
+	int		currentBits;
+	int		groupSamples;
+	int		groupBytes;
+	uint32_t	sequence;
+	std::vector<uint8_t>	datagram;
+	int		fill;
+	int		samplesInDatagram;
+	std::vector<uint8_t>	converted;
+	std::atomic<uint64_t>	nrSent;
+	std::atomic<uint64_t>	nrFailed;
+	std::atomic<uint64_t>	nrDropped;
+	void		sendDatagram	();
+};
+